@@ -76,6 +76,7 @@ A KNX daemon and tools supporting it.
 
 # /usr/bin
 %{_bindir}/knxd
+%{_bindir}/knxd-tracefmt
 %{_bindir}/knxtool
 %{_bindir}/findknxusb
 
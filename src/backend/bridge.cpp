@@ -0,0 +1,165 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <map>
+#include <mutex>
+
+#include "bridge.h"
+
+static std::mutex pipes_lock;
+static std::map<std::string, BridgePipePtr> pipes;
+
+BridgePipe::BridgePipe (struct ev_loop *l0, struct ev_loop *l1)
+{
+  end[0] = std::unique_ptr<End>(new End (l0));
+  end[1] = std::unique_ptr<End>(new End (l1));
+}
+
+BridgePipe::~BridgePipe ()
+{
+  L_Data_PDU *p;
+  for (auto &e : end)
+    while (e->in.pop (p))
+      delete p;
+}
+
+void
+BridgePipe::create (const std::string& name, struct ev_loop *l0, struct ev_loop *l1)
+{
+  std::lock_guard<std::mutex> g (pipes_lock);
+  pipes[name] = std::make_shared<BridgePipe> (l0, l1);
+}
+
+BridgePipePtr
+BridgePipe::find (const std::string& name)
+{
+  std::lock_guard<std::mutex> g (pipes_lock);
+  auto p = pipes.find (name);
+  if (p == pipes.end())
+    return nullptr;
+  return p->second;
+}
+
+void
+BridgePipe::clear ()
+{
+  std::lock_guard<std::mutex> g (pipes_lock);
+  pipes.clear();
+}
+
+BridgeDriver::BridgeDriver (const LinkConnectPtr_& c, IniSectionPtr& s)
+  : BusDriver(c,s)
+{
+  setAuxName("bridge");
+}
+
+BridgeDriver::~BridgeDriver ()
+{
+  stop();
+}
+
+bool
+BridgeDriver::setup()
+{
+  if (!BusDriver::setup())
+    return false;
+  pipe = BridgePipe::find (cfg->value("bridge",""));
+  if (pipe == nullptr)
+    {
+      ERRORPRINTF (t, E_ERROR | 69, "%s: bridges are set up by the 'domains' option", cfg->name);
+      return false;
+    }
+  int side = cfg->value("side",0) ? 1 : 0;
+  me = pipe->end[side].get();
+  peer = pipe->end[1-side].get();
+  me->wakeup.set<BridgeDriver,&BridgeDriver::wakeup_cb>(this);
+  return true;
+}
+
+void
+BridgeDriver::start()
+{
+  if (me == nullptr)
+    {
+      stopped();
+      return;
+    }
+  me->wakeup.start();
+  BusDriver::start();
+  /* pick up whatever arrived while we were stopped */
+  me->wakeup.send();
+}
+
+void
+BridgeDriver::stop()
+{
+  if (me != nullptr)
+    me->wakeup.stop();
+  delete pending;
+  pending = nullptr;
+  BusDriver::stop();
+}
+
+void
+BridgeDriver::send_L_Data (LDataPtr l)
+{
+  pending = l.release();
+  if (push_pending ())
+    send_Next();
+}
+
+/** Queue the pending frame for the other domain. If there's no room,
+ * keep it; the other side wakes us up when it has emptied its queue. */
+bool
+BridgeDriver::push_pending ()
+{
+  if (!peer->in.push (std::move(pending)))
+    {
+      me->blocked = true;
+      /* The other side may have made room before it saw our flag. The
+       * fence pairs with the one in wakeup_cb. */
+      std::atomic_thread_fence (std::memory_order_seq_cst);
+      if (!peer->in.push (std::move(pending)))
+        return false;
+      me->blocked = false;
+    }
+  pending = nullptr;
+  peer->wakeup.send();
+  return true;
+}
+
+void
+BridgeDriver::wakeup_cb (ev::async &w UNUSED, int revents UNUSED)
+{
+  L_Data_PDU *p;
+  bool popped = false;
+  while (me->in.pop (p))
+    {
+      popped = true;
+      recv_L_Data (LDataPtr(p));
+    }
+  if (popped)
+    {
+      std::atomic_thread_fence (std::memory_order_seq_cst);
+      if (peer->blocked.exchange (false))
+        peer->wakeup.send();
+    }
+  if (pending != nullptr && push_pending ())
+    send_Next();
+}
@@ -0,0 +1,98 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef BRIDGE_H
+#define BRIDGE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "link.h"
+#include "lpdu.h"
+#include "spscqueue.h"
+
+/** length of each direction's queue */
+#define BRIDGE_QUEUE 256
+
+class BridgePipe;
+typedef std::shared_ptr<BridgePipe> BridgePipePtr;
+
+/** The connection between the two ends of a bridge.
+ *
+ * knxd runs each routing domain (see the "domains" option) in its own
+ * thread, with its own event loop. A bridge joins two of them: each end
+ * has a lock-free queue of frames for it, filled by the other end, and an
+ * async watcher on its own loop which the other end uses to wake it up.
+ */
+class BridgePipe
+{
+public:
+  struct End
+  {
+    /** frames for this end; owned by the queue until they're popped */
+    SPSCQueue<L_Data_PDU *> in;
+    /** runs on this end's loop */
+    ev::async wakeup;
+    /** this end has a frame which didn't fit into the other end's queue */
+    std::atomic<bool> blocked {false};
+
+    End (struct ev_loop *l) : in(BRIDGE_QUEUE), wakeup(l) {}
+  };
+
+  std::unique_ptr<End> end[2];
+
+  BridgePipe (struct ev_loop *l0, struct ev_loop *l1);
+  ~BridgePipe ();
+
+  /** Create a pipe; side 0 runs on loop l0, side 1 on l1. */
+  static void create (const std::string& name, struct ev_loop *l0, struct ev_loop *l1);
+  static BridgePipePtr find (const std::string& name);
+  /** Forget all pipes; only when no domain is running any more. */
+  static void clear ();
+};
+
+/** Link between two routing domains of the same knxd.
+ *
+ * knxd sets up these links itself; "bridge" and "side" are not user
+ * options.
+ */
+DRIVER(BridgeDriver,bridge)
+{
+  BridgePipePtr pipe;
+  /** the end which our domain reads from, and the other one */
+  BridgePipe::End *me = nullptr, *peer = nullptr;
+  /** a frame which didn't fit into the other end's queue */
+  L_Data_PDU *pending = nullptr;
+
+  void wakeup_cb (ev::async &w, int revents);
+  bool push_pending ();
+
+public:
+  BridgeDriver (const LinkConnectPtr_& c, IniSectionPtr& s);
+  virtual ~BridgeDriver ();
+
+  bool setup();
+  void start();
+  void stop();
+
+  void send_L_Data (LDataPtr l);
+};
+
+#endif
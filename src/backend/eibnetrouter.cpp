@@ -63,6 +63,8 @@ EIBNetIPRouter::start()
   mcfg.imr_interface.s_addr = htonl (INADDR_ANY);
   if (!sock->SetMulticast (mcfg))
     goto err_out;
+  if (io_thread && !sock->start_thread ())
+    goto err_out;
   TRACEPRINTF (t, 2, "Opened");
   BusDriver::start();
   return;
@@ -107,6 +109,7 @@ EIBNetIPRouter::setup()
   port = cfg->value("port",3671);
   interface = cfg->value("interface","");
   monitor = cfg->value("monitor",false);
+  io_thread = cfg->value("io-thread",false);
   return true;
 }
 
@@ -33,6 +33,8 @@ DRIVER(EIBNetIPRouter,ip)
   std::string multicastaddr;
   uint16_t port;
   bool monitor;
+  /** run the socket in its own thread */
+  bool io_thread;
 
   void read_cb(EIBNetIPPacket *p);
   void stop_();
@@ -50,9 +50,9 @@ DRIVER(EIBNetIPTunnel,ipt)
   int heartbeat_limit;
   int retry = 0;
 
-  ev::timer timeout; void timeout_cb(ev::timer &w, int revents);
-  ev::timer conntimeout; void conntimeout_cb(ev::timer &w, int revents);
-  ev::async trigger; void trigger_cb(ev::async &w, int revents);
+  ev::timer timeout {loop}; void timeout_cb(ev::timer &w, int revents);
+  ev::timer conntimeout {loop}; void conntimeout_cb(ev::timer &w, int revents);
+  ev::async trigger {loop}; void trigger_cb(ev::async &w, int revents);
   
   bool support_busmonitor;
   bool connect_busmonitor;
@@ -52,7 +52,7 @@ FILTER(PaceFilter,pace)
   float factor_in;
   size_t last_len;
   enum PSTATE state;
-  ev::timer timer; void timer_cb(ev::timer &w, int revents);
+  ev::timer timer {loop}; void timer_cb(ev::timer &w, int revents);
 
 public:
   PaceFilter (const LinkConnectPtr_& c, IniSectionPtr& s);
@@ -40,7 +40,7 @@ FILTER(QueueFilter,queue)
 {
   Queue < LDataPtr > buf;
   enum QSTATE state;
-  ev::async trigger;
+  ev::async trigger {loop};
   void trigger_cb (ev::async &w, int revents);
 
 public:
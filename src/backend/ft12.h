@@ -95,9 +95,9 @@ class FT12wrap : public LowLevelFilter
   /** set up send and recv buffers, timers, etc. */
   void setup_buffers();
 
-  ev::async trigger; void trigger_cb (ev::async &w, int revents);
-  ev::timer timer; void timer_cb (ev::timer &w, int revents);
-  ev::timer sendtimer; void sendtimer_cb (ev::timer &w, int revents);
+  ev::async trigger {loop}; void trigger_cb (ev::async &w, int revents);
+  ev::timer timer {loop}; void timer_cb (ev::timer &w, int revents);
+  ev::timer sendtimer {loop}; void sendtimer_cb (ev::timer &w, int revents);
   /** process incoming data */
   void process_read (bool is_timeout);
   void do_send_Next ();
@@ -84,7 +84,7 @@ void
 LogFilter::recv_L_Data (LDataPtr l)
 {
   if (log_recv)
-    t->TracePrintf (0, "Recv %s", l->Decode (t));
+    t->TracePrintf (0, "Recv %s", l->text (t));
   Filter::recv_L_Data(std::move(l));
 }
 
@@ -100,7 +100,7 @@ void
 LogFilter::send_L_Data (LDataPtr l)
 {
   if (log_send)
-    t->TracePrintf (0, "Send %s", l->Decode (t));
+    t->TracePrintf (0, "Send %s", l->text (t));
   Filter::send_L_Data(std::move(l));
 }
 
@@ -108,7 +108,7 @@ void
 LogFilter::recv_L_Busmonitor (LBusmonPtr l)
 {
   if (log_monitor)
-    t->TracePrintf (0, "Monitor %s", l->Decode (t));
+    t->TracePrintf (0, "Monitor %s", l->text (t));
   Filter::recv_L_Busmonitor(std::move(l));
 }
 
@@ -244,13 +244,13 @@ void LLlog::errored ()
 
 void LLlog::recv_L_Data(LDataPtr l)
 {
-  tr()->TracePrintf (0, "Recv %s", l->Decode (t));
+  tr()->TracePrintf (0, "Recv %s", l->text (t));
   master->recv_L_Data(std::move(l));
 }
 
 void LLlog::send_L_Data(LDataPtr l)
 {
-  tr()->TracePrintf (0, "Send %s", l->Decode (t));
+  tr()->TracePrintf (0, "Send %s", l->text (t));
   iface->send_L_Data(std::move(l));
 }
 
@@ -284,7 +284,7 @@ void LLlog::do_send_Local(CArray& l, int raw)
 
 void LLlog::recv_L_Busmonitor(LBusmonPtr l)
 {
-  tr()->TracePrintf (0, "Monitor %s", l->Decode (tr()));
+  tr()->TracePrintf (0, "Monitor %s", l->text (tr()));
   master->recv_L_Busmonitor(std::move(l));
 }
 
@@ -0,0 +1,405 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "pcap.h"
+#include "emi.h"
+
+/* pcapng block types and options */
+#define PCAPNG_SHB 0x0A0D0D0A
+#define PCAPNG_IDB 0x00000001
+#define PCAPNG_EPB 0x00000006
+#define PCAPNG_MAGIC 0x1A2B3C4D
+#define OPT_ENDOFOPT 0
+#define OPT_SHB_USERAPPL 4
+#define OPT_IF_NAME 2
+#define OPT_IF_TSRESOL 9
+#define OPT_EPB_FLAGS 2
+
+#define EPB_INBOUND 1
+#define EPB_OUTBOUND 2
+
+/** Wireshark's "exported PDU" link type. The packet starts with a list of
+ * tags which name the dissector to use. */
+#define LINKTYPE_WIRESHARK_UPPER_PDU 252
+#define EXP_PDU_TAG_END_OF_OPT 0
+#define EXP_PDU_TAG_PROTO_NAME 12
+
+/** write the output buffer when it gets this large */
+#define PCAP_FLUSH_SIZE 65536
+
+/** A capture file, shared by all filters which write to it */
+class PcapFile
+{
+  std::string path;
+  int fd = -1;
+  TracePtr t;
+  /** the loop of the routing domain which uses this file */
+  LOOP_RESULT owner;
+
+  /** rotate when the file gets larger than this; 0: don't */
+  size_t max_size;
+  /** rotate when the file gets older than this; 0: don't */
+  ev_tstamp max_age;
+  /** number of rotated files to keep */
+  int keep;
+
+  size_t written = 0;
+  ev_tstamp opened;
+  /** the file couldn't be reopened after rotating; retry on the timer */
+  bool broken = false;
+  /** frames lost while broken */
+  unsigned long dropped = 0;
+  std::vector<uint8_t> buf;
+  /** links in the current file, in interface ID order */
+  std::vector<std::weak_ptr<PcapIface>> ifaces;
+
+  ev::timer flush_timer {loop}; void flush_timer_cb(ev::timer &w, int revents);
+
+  void put32 (uint32_t x) { buf.insert (buf.end(), (uint8_t *)&x, (uint8_t *)&x + 4); }
+  void put16 (uint16_t x) { buf.insert (buf.end(), (uint8_t *)&x, (uint8_t *)&x + 2); }
+  void put (const void *p, size_t len)
+    {
+      buf.insert (buf.end(), (const uint8_t *)p, (const uint8_t *)p + len);
+      buf.resize ((buf.size() + 3) & ~3);
+    }
+  void option (uint16_t code, const void *p, size_t len)
+    {
+      put16 (code);
+      put16 (len);
+      put (p, len);
+    }
+  /** start a block; returns its offset for end_block() */
+  size_t begin_block (uint32_t type)
+    {
+      size_t pos = buf.size();
+      put32 (type);
+      put32 (0);
+      return pos;
+    }
+  void end_block (size_t pos)
+    {
+      uint32_t len = buf.size() + 4 - pos;
+      memcpy (&buf[pos + 4], &len, 4);
+      put32 (len);
+    }
+
+  void write_shb ();
+  void write_idb (const std::string& name);
+  bool open ();
+  void rotate ();
+
+public:
+  PcapFile (const std::string& p, TracePtr tr) : path(p), t(tr), owner(loop) {}
+  ~PcapFile ();
+
+  bool setup (IniSectionPtr& s);
+  PcapIfacePtr add_interface (const std::string& name);
+  void packet (const PcapIface& iface, uint32_t flags, const CArray& cemi);
+  void flush ();
+
+  /** @return nullptr if another routing domain uses this file */
+  static PcapFilePtr get (const std::string& path, TracePtr t);
+};
+
+/* never freed: filters may outlive static destructors.
+ * Routing domains set up their filters in parallel, hence the lock. */
+static std::map<std::string, std::weak_ptr<PcapFile>> &pcap_files =
+  *new std::map<std::string, std::weak_ptr<PcapFile>>;
+static std::mutex &pcap_files_lock = *new std::mutex;
+
+PcapFilePtr
+PcapFile::get (const std::string& path, TracePtr t)
+{
+  std::lock_guard<std::mutex> g(pcap_files_lock);
+  PcapFilePtr f = pcap_files[path].lock();
+  if (f == nullptr)
+    {
+      f = PcapFilePtr(new PcapFile(path, t));
+      pcap_files[path] = f;
+    }
+  else if (f->owner != loop)
+    {
+      /* its buffer and timer belong to the other domain's thread */
+      ERRORPRINTF (t, E_ERROR | 73, "pcap: %s is used by another routing domain", path);
+      return nullptr;
+    }
+  return f;
+}
+
+bool
+PcapFile::setup (IniSectionPtr& s)
+{
+  if (fd >= 0) // shared
+    return true;
+
+  max_size = s->value("max-size", 0);
+  max_age = s->value("max-age", 0);
+  keep = s->value("keep", 9);
+  buf.reserve (PCAP_FLUSH_SIZE + 512);
+
+  flush_timer.set<PcapFile,&PcapFile::flush_timer_cb>(this);
+  if (!open ())
+    return false;
+  flush_timer.start(1,1);
+  return true;
+}
+
+PcapFile::~PcapFile ()
+{
+  flush_timer.stop();
+  flush ();
+  if (fd >= 0)
+    close (fd);
+  std::lock_guard<std::mutex> g(pcap_files_lock);
+  auto i = pcap_files.find (path);
+  if (i != pcap_files.end() && i->second.expired())
+    pcap_files.erase (i);
+}
+
+bool
+PcapFile::open ()
+{
+  fd = ::open (path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+  if (fd < 0)
+    {
+      if (!broken)
+        ERRORPRINTF (t, E_ERROR | 64, "pcap: cannot open %s: %s", path, strerror(errno));
+      return false;
+    }
+  if (broken)
+    {
+      ERRORPRINTF (t, E_WARNING | 72, "pcap: reopened %s, %lu frames lost", path, dropped);
+      broken = false;
+      dropped = 0;
+    }
+  written = 0;
+  opened = ev_now(loop);
+  write_shb ();
+
+  /* Client links come and go; only describe those which still exist */
+  unsigned int n = 0;
+  for (unsigned int i = 0; i < ifaces.size(); i++)
+    {
+      PcapIfacePtr ifc = ifaces[i].lock();
+      if (ifc == nullptr)
+        continue;
+      ifc->id = n;
+      ifaces[n++] = ifc;
+      write_idb (ifc->name);
+    }
+  ifaces.resize (n);
+  return true;
+}
+
+void
+PcapFile::rotate ()
+{
+  flush ();
+  close (fd);
+  fd = -1;
+
+  if (keep > 0)
+    {
+      for (int i = keep - 1; i > 0; i--)
+        rename ((path + "." + std::to_string (i)).c_str(),
+                (path + "." + std::to_string (i + 1)).c_str());
+      rename (path.c_str(), (path + ".1").c_str());
+    }
+  if (!open ())
+    {
+      buf.clear();
+      broken = true;
+    }
+}
+
+void
+PcapFile::flush ()
+{
+  if (buf.empty() || fd < 0)
+    return;
+  size_t pos = 0;
+  while (pos < buf.size())
+    {
+      ssize_t n = ::write (fd, buf.data() + pos, buf.size() - pos);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          ERRORPRINTF (t, E_ERROR | 65, "pcap: cannot write %s: %s", path, strerror(errno));
+          break;
+        }
+      pos += n;
+    }
+  written += pos;
+  buf.clear();
+}
+
+void
+PcapFile::flush_timer_cb (ev::timer &w UNUSED, int revents UNUSED)
+{
+  if (broken)
+    {
+      open ();
+      return;
+    }
+  flush ();
+  if (max_age > 0 && ev_now(loop) - opened >= max_age)
+    rotate ();
+}
+
+void
+PcapFile::write_shb ()
+{
+  static const char appl[] = "knxd";
+
+  size_t pos = begin_block (PCAPNG_SHB);
+  put32 (PCAPNG_MAGIC);
+  put16 (1); // version 1.0
+  put16 (0);
+  put32 (0xFFFFFFFF); // section length: unknown
+  put32 (0xFFFFFFFF);
+  option (OPT_SHB_USERAPPL, appl, sizeof(appl) - 1);
+  option (OPT_ENDOFOPT, nullptr, 0);
+  end_block (pos);
+}
+
+void
+PcapFile::write_idb (const std::string& name)
+{
+  uint8_t tsresol = 9; // nsec
+
+  size_t pos = begin_block (PCAPNG_IDB);
+  put16 (LINKTYPE_WIRESHARK_UPPER_PDU);
+  put16 (0);
+  put32 (0); // snaplen: unlimited
+  option (OPT_IF_NAME, name.data(), name.size());
+  option (OPT_IF_TSRESOL, &tsresol, 1);
+  option (OPT_ENDOFOPT, nullptr, 0);
+  end_block (pos);
+}
+
+PcapIfacePtr
+PcapFile::add_interface (const std::string& name)
+{
+  PcapIfacePtr ifc = PcapIfacePtr(new PcapIface { name, (unsigned int)ifaces.size() });
+  ifaces.push_back (ifc);
+  if (fd >= 0)
+    write_idb (name);
+  return ifc;
+}
+
+void
+PcapFile::packet (const PcapIface& iface, uint32_t flags, const CArray& cemi)
+{
+  /* exported-PDU header: the tags are big-endian */
+  static const uint8_t hdr[] = {
+    0, EXP_PDU_TAG_PROTO_NAME, 0, 4, 'c','e','m','i',
+    0, EXP_PDU_TAG_END_OF_OPT, 0, 0,
+  };
+  if (fd < 0)
+    {
+      dropped++;
+      return;
+    }
+
+  struct timespec ts;
+  clock_gettime (CLOCK_REALTIME, &ts);
+  uint64_t ns = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+  uint32_t len = sizeof(hdr) + cemi.size();
+
+  size_t pos = begin_block (PCAPNG_EPB);
+  put32 (iface.id);
+  put32 (ns >> 32);
+  put32 (ns);
+  put32 (len);
+  put32 (len);
+  buf.insert (buf.end(), hdr, hdr + sizeof(hdr));
+  put (cemi.data(), cemi.size());
+  option (OPT_EPB_FLAGS, &flags, 4);
+  option (OPT_ENDOFOPT, nullptr, 0);
+  end_block (pos);
+
+  if (buf.size() >= PCAP_FLUSH_SIZE)
+    flush ();
+  if (max_size > 0 && written + buf.size() >= max_size)
+    rotate ();
+}
+
+
+PcapFilter::~PcapFilter() { }
+
+bool
+PcapFilter::setup()
+{
+  if (!Filter::setup())
+    return false;
+  auto cn = conn.lock();
+  if (cn == nullptr)
+    return false;
+
+  std::string path = cfg->value("file","");
+  if (path.empty())
+    {
+      ERRORPRINTF (t, E_ERROR | 64, "pcap: 'file' is required");
+      return false;
+    }
+  cap_send = cfg->value("send",true);
+  cap_recv = cfg->value("recv",true);
+  cap_monitor = cfg->value("monitor",true);
+
+  file = PcapFile::get(path, t);
+  if (file == nullptr || !file->setup(cfg))
+    return false;
+  iface = file->add_interface(cn->name());
+  return true;
+}
+
+void
+PcapFilter::recv_L_Data (LDataPtr l)
+{
+  if (cap_recv)
+    file->packet (*iface, EPB_INBOUND, L_Data_ToCEMI (0x29, l));
+  Filter::recv_L_Data(std::move(l));
+}
+
+void
+PcapFilter::send_L_Data (LDataPtr l)
+{
+  if (cap_send)
+    file->packet (*iface, EPB_OUTBOUND, L_Data_ToCEMI (0x11, l));
+  Filter::send_L_Data(std::move(l));
+}
+
+void
+PcapFilter::recv_L_Busmonitor (LBusmonPtr l)
+{
+  if (cap_monitor)
+    file->packet (*iface, EPB_INBOUND, Busmonitor_to_CEMI (0x2B, *l, monitor_seq++));
+  Filter::recv_L_Busmonitor(std::move(l));
+}
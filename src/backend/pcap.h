@@ -0,0 +1,71 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/**
+
+This module implements a filter which writes the packets passing through
+it, together with their timestamp, direction and link name, to a pcapng
+file which Wireshark can read directly.
+
+Packets are stored as cEMI frames, wrapped in Wireshark's "exported PDU"
+link type so that its cEMI dissector picks them up. Nothing is decoded
+to text; capturing a frame costs a copy into the file's output buffer.
+
+Filters with the same "file" share that file. Each link gets its own
+interface in the capture.
+*/
+
+#ifndef PCAP_H
+#define PCAP_H
+#include "link.h"
+
+class PcapFile;
+typedef std::shared_ptr<PcapFile> PcapFilePtr;
+
+/** a link's interface in the capture file */
+struct PcapIface
+{
+  std::string name;
+  /** interface ID; changes when the file is rotated */
+  unsigned int id;
+};
+typedef std::shared_ptr<PcapIface> PcapIfacePtr;
+
+FILTER(PcapFilter,pcap)
+{
+  bool cap_send;
+  bool cap_recv;
+  bool cap_monitor;
+
+  PcapFilePtr file;
+  PcapIfacePtr iface;
+  /** sequence number in the cEMI busmonitor status */
+  int monitor_seq = 0;
+
+public:
+  PcapFilter (const LinkConnectPtr_& c, IniSectionPtr& s) : Filter(c,s) {}
+  virtual ~PcapFilter ();
+
+  virtual bool setup();
+  virtual void recv_L_Data (LDataPtr l);
+  virtual void send_L_Data (LDataPtr l);
+  virtual void recv_L_Busmonitor (LBusmonPtr l);
+};
+
+#endif
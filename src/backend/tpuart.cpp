@@ -66,8 +66,8 @@ TPUARTwrap::create_serial(LowLevelIface* parent, IniSectionPtr& s)
 
 static const char* SN(enum TSTATE s)
 {
-  static int x = 0;
-  static char buf[2][10];
+  static thread_local int x = 0;
+  static thread_local char buf[2][10];
   switch(s)
     {
     case T_new:            return "new";
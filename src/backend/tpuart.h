@@ -80,8 +80,8 @@ protected:
   bool send_wait = false;
 
   /** main loop state */
-  ev::timer timer; void timer_cb(ev::timer &w, int revents);
-  ev::timer sendtimer; void sendtimer_cb(ev::timer &w, int revents);
+  ev::timer timer {loop}; void timer_cb(ev::timer &w, int revents);
+  ev::timer sendtimer {loop}; void sendtimer_cb(ev::timer &w, int revents);
 
   LPDUPtr sending;
   CArray in, out;
@@ -314,12 +314,14 @@ int _EIB_GetRequest (EIBConnection * con);
 #define AGARG_UINT8b(name, args) uint8_t name KAG ## args
 #define AGARG_UINT16(name, args) uint16_t name KAG ## args
 #define AGARG_UINT32(name, args) uint32_t name KAG ## args
+#define AGARG_UINT32a(name, args) uint32_t name KAG ## args
 #define AGARG_OUTUINT8(name, args) uint8_t *name KAG ## args
 #define AGARG_OUTUINT8a(name, args) uint8_t *name KAG ## args
 #define AGARG_OUTUINT16(name, args) uint16_t *name KAG ## args
 #define AGARG_OUTINT16(name, args) int16_t *name KAG ## args
 #define AGARG_OUTUINT32(name, args) uint32_t *name KAG ## args
 #define AGARG_ADDR(name, args) eibaddr_t name KAG ## args
+#define AGARG_ADDRa(name, args) eibaddr_t name KAG ## args
 #define AGARG_OUTADDR(name, args) eibaddr_t *name KAG ## args
 #define AGARG_OUTADDRa(name, args) eibaddr_t *name KAG ## args
 #define AGARG_INBUF(name, args) int name##_len, const uint8_t *name KAG ## args
@@ -334,12 +336,14 @@ int _EIB_GetRequest (EIBConnection * con);
 #define ALARG_UINT8b(name, args) name KAL ## args
 #define ALARG_UINT16(name, args) name KAL ## args
 #define ALARG_UINT32(name, args) name KAL ## args
+#define ALARG_UINT32a(name, args) name KAL ## args
 #define ALARG_OUTUINT8(name, args) name KAL ## args
 #define ALARG_OUTUINT8a(name, args) name KAL ## args
 #define ALARG_OUTUINT16(name, args) name KAL ## args
 #define ALARG_OUTINT16(name, args) name KAL ## args
 #define ALARG_OUTUINT32(name, args) name KAL ## args
 #define ALARG_ADDR(name, args) name KAL ## args
+#define ALARG_ADDRa(name, args) name KAL ## args
 #define ALARG_OUTADDR(name, args) name KAL ## args
 #define ALARG_OUTADDRa(name, args) name KAL ## args
 #define ALARG_INBUF(name, args) name##_len, name KAL ## args
@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <tuple>
 
 #include <assert.h>
 #include <string.h>
@@ -50,11 +51,12 @@ IniSection::value(const std::string& name, const std::string& def)
       v = values.find("use");
       if (v == values.end())
         return def;
-      return parent[v->second.first]->value(name,def);
+      return parent[v->second.value]->value(name,def);
     }
 
-  v->second.second = true;
-  return v->second.first;
+  if (!v->second.seen.load(std::memory_order_relaxed))
+    v->second.seen.store(true, std::memory_order_relaxed);
+  return v->second.value;
 }
 
 const std::string
@@ -73,10 +75,12 @@ IniSection::operator[](const char *name)
     {
       auto v = values.find(name);
       assert (v != values.end());
-      return v->second.first;
+      return v->second.value;
     } else {
-      auto res = values.emplace(name, ValueType("",false));
-      return res.first->second.first;
+      auto res = values.emplace(std::piecewise_construct,
+                                std::forward_as_tuple(name),
+                                std::forward_as_tuple(""));
+      return res.first->second.value;
     }
 }
 
@@ -181,6 +185,7 @@ IniData::add_auto(std::string& section)
 IniSectionPtr&
 IniData::operator[](const char *name)
 {
+  std::lock_guard<std::mutex> g(lock);
   auto v = sections.find(name);
   if (v == sections.end())
     {
@@ -188,7 +193,8 @@ IniData::operator[](const char *name)
       auto res = sections.emplace(name, SectionType(sec,false));
       v = res.first;
     }
-  v->second.second = true;
+  if (!v->second.second)
+    v->second.second = true;
   return v->second.first;
 }
 
@@ -207,7 +213,9 @@ IniSection::add(const char *name, const char *value)
   if (value == NULL)
     value = "TRUE"; // assume bool flag
 
-  auto res2 = values.emplace(name, ValueType(value,false));
+  auto res2 = values.emplace(std::piecewise_construct,
+                             std::forward_as_tuple(name),
+                             std::forward_as_tuple(value));
   if (! res2.second)
     {
       std::cerr << "Parse error: Duplicate value: " << name << std::endl;
@@ -257,7 +265,7 @@ void
 IniSection::write(std::ostream& file)
 {
   ITER(i,values)
-    file << i->first << " = " << i->second.first << std::endl;
+    file << i->first << " = " << i->second.value << std::endl;
 }
 
 void
@@ -276,9 +284,9 @@ IniSection::list_unseen(UnseenViewer uv, void *x)
   bool res = false;
   ITER(i,values)
     {
-      if (!i->second.second)
+      if (!i->second.seen.load(std::memory_order_relaxed))
         {
-          if (uv(x, *this, i->first, i->second.first))
+          if (uv(x, *this, i->first, i->second.value))
             res = true;
         }
     }
@@ -26,11 +26,21 @@
 
 #include "inih.h"
 //#include <unordered_map>
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <string>
 #include <memory>
 
-typedef std::pair<std::string,bool> ValueType;
+struct ValueType
+{
+  std::string value;
+  /** set by IniSection::value(), which routing domains call from their
+   * own threads */
+  std::atomic<bool> seen {false};
+
+  ValueType(const char *v) : value(v) {}
+};
 typedef std::map<std::string, ValueType> ValueMap;
 
 class IniData;
@@ -77,6 +87,8 @@ typedef std::pair<IniSectionPtr,bool> SectionType;
 typedef std::map<std::string, SectionType> SectionMap;
 class IniData {
     SectionMap sections;
+    /** routing domains look up sections from their own threads */
+    std::mutex lock;
 
 public:
     bool read_only = false;
@@ -23,6 +23,22 @@
 #include <fcntl.h>
 #include "iobuf.h"
 
+void SendBuf::write(const uchar *buf, size_t len)
+{
+  if (!ready)
+    {
+      ssize_t done = ::write(fd, buf, len);
+      if (done == (ssize_t)len)
+        return;
+      if (done > 0)
+        {
+          buf += done;
+          len -= done;
+        }
+    }
+  write(new CArray(buf, len));
+}
+
 void SendBuf::write(const CArray *data)
 {
   if (!ready)
@@ -80,8 +96,10 @@ void
 RecvBuf::io_cb (ev::io &w UNUSED, int revents UNUSED)
 {
     bool some = false;
-    while(sizeof(recvbuf) > recvpos) {
-	int i = ::read(fd, recvbuf+recvpos, quick ? 1 : (sizeof(recvbuf)-recvpos));
+    while(RECVBUF_SIZE > recvpos) {
+        if (recvpos == recvsize)
+            grow();
+	int i = ::read(fd, recvbuf.get()+recvpos, quick ? 1 : (recvsize-recvpos));
 	if (i <= 0) {
             if (some)
                 break;
@@ -99,12 +117,27 @@ RecvBuf::io_cb (ev::io &w UNUSED, int revents UNUSED)
     feed_out();
 }
 
+void RecvBuf::grow()
+{
+    size_t size = recvsize ? 2 * recvsize : RECVBUF_MIN;
+    if (size > RECVBUF_SIZE)
+        size = RECVBUF_SIZE;
+    uint8_t *buf = new uint8_t[size];
+    if (recvpos)
+        memcpy(buf,recvbuf.get(),recvpos);
+    recvbuf.reset(buf);
+    recvsize = size;
+}
+
 void RecvBuf::feed_out()
 {
     while (running && recvpos > 0) {
-        size_t i = on_read(recvbuf,recvpos);
+        size_t i = on_read(recvbuf.get(),recvpos);
+        /* on_read() may run the event loop, which may have read more
+         * data and grown the buffer */
+        uint8_t *buf = recvbuf.get();
         if (i == 0) {
-            if (recvpos == sizeof(recvbuf)) {
+            if (recvpos == RECVBUF_SIZE) {
                 io.stop();
                 on_error();
             }
@@ -114,7 +147,7 @@ void RecvBuf::feed_out()
             recvpos = 0;
         else {
             recvpos -= i;
-            memmove(recvbuf,recvbuf+i,recvpos);
+            memmove(buf,buf+i,recvpos);
         }
     }
 
@@ -28,13 +28,24 @@
 #include "callbacks.h"
 #include <assert.h>
 #include <ev++.h>
+#include <memory>
 #include <queue.h>
 
 void set_non_blocking(int fd);
 
+#if EV_MULTIPLICITY
+/** the current thread's event loop, see libserver/common.h */
+extern thread_local struct ev_loop *loop;
+#endif
+
+/** largest message a RecvBuf can hold */
+#define RECVBUF_SIZE 1024
+/** initial size of a RecvBuf's buffer; it grows as needed */
+#define RECVBUF_MIN 64
+
 class SendBuf
 {
-  ev::io io;
+  ev::io io {loop};
   void io_cb (ev::io &w, int revents);
 
 public:
@@ -70,10 +81,8 @@ public:
   void start();
   void stop(bool clear = false);
 
-  void write(const uchar *buf, size_t len) {
-    CArray *data = new CArray(buf, len);
-    write(data);
-  }
+  /** Copies the data only if it can't be written right away. */
+  void write(const uchar *buf, size_t len);
 
   void write(const CArray *data);
 
@@ -90,7 +99,7 @@ protected:
 
 class RecvBuf
 {
-  ev::io io;
+  ev::io io {loop};
   void io_cb (ev::io &w, int revents);
   bool quick = false;
 
@@ -126,11 +135,16 @@ protected:
   /** client connection */
   int fd = -1;
 
-  /** receiving */
-  uint8_t recvbuf[1024];
+  /** receiving.
+   * Most clients only ever send short messages, so the buffer is
+   * allocated on the first read and starts small. */
+  std::unique_ptr<uint8_t[]> recvbuf;
+  size_t recvsize = 0;
   size_t recvpos = 0;
   int len = 0; // of current block
   void feed_out();
+  /** make room for more data, up to RECVBUF_SIZE */
+  void grow();
 
 };
 
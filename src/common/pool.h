@@ -0,0 +1,104 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <atomic>
+#include <new>
+#include <stddef.h>
+
+/** allocation statistics of a pooled class */
+struct PoolStats
+{
+  /** allocations served from the free list */
+  std::atomic<unsigned long> hits;
+  /** allocations which had to go to the heap */
+  std::atomic<unsigned long> misses;
+};
+
+/** Class-level allocator which recycles freed objects.
+ *
+ * Derive T from Pooled<T>; "new T" and "delete" (also through a
+ * std::unique_ptr or a pointer to a base class with a virtual destructor)
+ * then take blocks from, and return them to, a free list. Each thread has
+ * its own free list, so no locking is needed; at most MAXFREE blocks are
+ * kept per thread.
+ */
+template<class T, size_t MAXFREE = 256>
+class Pooled
+{
+  struct FreeList
+  {
+    void *head = nullptr;
+    size_t count = 0;
+    ~FreeList()
+    {
+      while (head)
+        {
+          void *next = *(void **)head;
+          ::operator delete (head);
+          head = next;
+        }
+      // objects freed after this point go straight to the heap
+      count = MAXFREE;
+    }
+  };
+  static FreeList &freelist ()
+  {
+    static thread_local FreeList f;
+    return f;
+  }
+
+public:
+  static PoolStats stats;
+
+  static void *operator new (size_t size)
+  {
+    FreeList &f = freelist ();
+    if (size == sizeof (T) && f.head)
+      {
+        void *p = f.head;
+        f.head = *(void **)p;
+        f.count--;
+        stats.hits.fetch_add (1, std::memory_order_relaxed);
+        return p;
+      }
+    stats.misses.fetch_add (1, std::memory_order_relaxed);
+    return ::operator new (size < sizeof (void *) ? sizeof (void *) : size);
+  }
+
+  static void operator delete (void *p, size_t size)
+  {
+    FreeList &f = freelist ();
+    if (p && size == sizeof (T) && f.count < MAXFREE)
+      {
+        *(void **)p = f.head;
+        f.head = p;
+        f.count++;
+        return;
+      }
+    ::operator delete (p);
+  }
+};
+
+template<class T, size_t MAXFREE>
+PoolStats Pooled<T, MAXFREE>::stats;
+
+#endif
@@ -21,24 +21,86 @@
 #define QUEUE_H
 
 #include <assert.h>
-#include <queue>
+#include <stddef.h>
 
-/** implement a generic FIFO queue*/
+#include <utility>
+#include <vector>
+
+/** implement a generic FIFO queue.
+ *
+ * The elements live in a ring buffer which doubles its size when it is
+ * full and never shrinks, so a queue which has reached its working size
+ * no longer allocates memory.
+ */
 template < typename _T >
-class Queue : public std::queue<_T>
+class Queue
 {
+  /** the ring; its size is zero or a power of two */
+  std::vector<_T> ring;
+  /** index of the first element */
+  size_t head = 0;
+  /** number of elements */
+  size_t count = 0;
+
+  void grow ()
+    {
+      std::vector<_T> n (ring.size() ? ring.size() * 2 : 8);
+      for (size_t i = 0; i < count; i++)
+        n[i] = std::move (ring[(head + i) & (ring.size() - 1)]);
+      ring.swap (n);
+      head = 0;
+    }
+
 public:
-  typedef typename std::queue<_T>::value_type value_type;
+  typedef _T value_type;
 
   /** initialize queue */
-  Queue () : std::queue<_T>() {};
+  Queue () {};
 
   /** destructor */
   virtual ~Queue () {}
 
-  using std::queue<_T>::front;
-  using std::queue<_T>::pop;
-  using std::queue<_T>::push;
+  size_t size () const { return count; }
+  bool empty () const { return count == 0; }
+
+  _T& front ()
+    {
+      assert (count);
+      return ring[head];
+    }
+  const _T& front () const
+    {
+      assert (count);
+      return ring[head];
+    }
+
+  void pop ()
+    {
+      assert (count);
+      ring[head] = _T();
+      head = (head + 1) & (ring.size() - 1);
+      count--;
+    }
+
+  void push (const _T& el)
+    {
+      if (count == ring.size())
+        grow ();
+      ring[(head + count++) & (ring.size() - 1)] = el;
+    }
+
+  void push (_T&& el)
+    {
+      if (count == ring.size())
+        grow ();
+      ring[(head + count++) & (ring.size() - 1)] = std::move (el);
+    }
+
+  template<typename... Args>
+  void emplace (Args&&... args)
+    {
+      push (_T(std::forward<Args>(args)...));
+    }
 
   inline void clear()
     {
@@ -48,20 +110,20 @@ public:
 
   inline void put (value_type && el)
     {
-      std::queue<_T>::push(std::move(el));
+      push(std::move(el));
     }
 
   inline _T get ()
     {
-      value_type v = std::move(std::queue<_T>::front());
-      std::queue<_T>::pop();
+      value_type v = std::move(front());
+      pop();
       return v;
     }
 
   /** return true, if the queue is empty */
   inline bool isempty () const
     {
-      return std::queue<_T>::empty();
+      return empty();
     }
 
 };
@@ -0,0 +1,101 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+/** A bounded FIFO queue between exactly one producer thread and one
+ * consumer thread.
+ *
+ * There are no locks: each side owns one index and only reads the
+ * other's. The capacity is fixed when the queue is created. When it is
+ * full, push() fails instead of blocking, so the producer decides whether
+ * to drop or retry.
+ */
+template < typename _T >
+class SPSCQueue
+{
+  std::unique_ptr<_T[]> ring;
+  size_t mask;
+
+  /** next slot to read; written by the consumer only */
+  std::atomic<size_t> head {0};
+  /** keep the two indices in separate cache lines */
+  char pad[64];
+  /** next slot to write; written by the producer only */
+  std::atomic<size_t> tail {0};
+
+public:
+  typedef _T value_type;
+
+  /** @param n capacity, rounded up to a power of two */
+  SPSCQueue (size_t n)
+    {
+      size_t size = 2;
+      while (size < n)
+        size <<= 1;
+      ring = std::unique_ptr<_T[]>(new _T[size]);
+      mask = size - 1;
+    }
+
+  /** producer: add an element; false if the queue is full */
+  bool push (_T&& el)
+    {
+      size_t t = tail.load (std::memory_order_relaxed);
+      if (t - head.load (std::memory_order_acquire) > mask)
+        return false;
+      ring[t & mask] = std::move (el);
+      tail.store (t + 1, std::memory_order_release);
+      return true;
+    }
+
+  /** consumer: remove the first element; false if the queue is empty */
+  bool pop (_T& el)
+    {
+      size_t h = head.load (std::memory_order_relaxed);
+      if (h == tail.load (std::memory_order_acquire))
+        return false;
+      el = std::move (ring[h & mask]);
+      ring[h & mask] = _T();
+      head.store (h + 1, std::memory_order_release);
+      return true;
+    }
+
+  /** producer: whether push() would fail right now */
+  bool full () const
+    {
+      return tail.load (std::memory_order_relaxed)
+             - head.load (std::memory_order_acquire) > mask;
+    }
+
+  /** either side: whether the queue is empty right now */
+  bool empty () const
+    {
+      return head.load (std::memory_order_acquire)
+             == tail.load (std::memory_order_acquire);
+    }
+};
+
+#endif
@@ -21,11 +21,18 @@
 #define TYPES_H
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
-#include <vector>
-#include <string>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
 #include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 #include "config.h"
 
@@ -61,57 +68,317 @@ typedef std::string String;
 inline unsigned int _sub(unsigned int _a, unsigned int _b) { return (_a>_b) ? _a-_b : 0; }
 inline unsigned int _min(unsigned int _a, unsigned int _b) { return (_a<_b) ? _a : _b; }
 
-typedef std::vector<uint8_t> u8vec; // less typing
-class CArray : public u8vec
+/** A vector of bytes which keeps short contents inline.
+  Standard KNX frames, and the EMI / cEMI packets carrying them, fit into
+  the inline buffer, so creating and copying them does not touch the heap.
+  Longer contents move to a heap buffer.
+
+  This implements the subset of std::vector<uint8_t> which knxd uses;
+  iterators are plain pointers.
+  */
+class u8vec
 {
 public:
-  /** start with various initializers */
-  CArray() : u8vec() { }
-  CArray(const CArray& __str, size_type __pos) : u8vec(_sub(__pos,__str.size()))
+  typedef uint8_t value_type;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  typedef uint8_t& reference;
+  typedef const uint8_t& const_reference;
+  typedef uint8_t *pointer;
+  typedef const uint8_t *const_pointer;
+  typedef uint8_t *iterator;
+  typedef const uint8_t *const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  /** number of bytes stored without a heap allocation */
+  static const size_type inline_size = 32;
+
+private:
+  uint8_t *p;
+  uint32_t n;
+  uint32_t cap;
+  uint8_t buf[inline_size];
+
+  bool is_inline () const { return p == buf; }
+  void grow (size_type want)
+  {
+    if (want <= cap)
+      return;
+    size_type c = cap * 2;
+    if (c < want)
+      c = want;
+    uint8_t *np = (uint8_t *) (is_inline () ? malloc (c) : realloc (p, c));
+    if (!np)
+      throw std::bad_alloc ();
+    if (is_inline ())
+      memcpy (np, buf, n);
+    p = np;
+    cap = c;
+  }
+  void release ()
+  {
+    if (!is_inline ())
+      free (p);
+    p = buf;
+    n = 0;
+    cap = inline_size;
+  }
+  /** take over the content of o, leaving it empty */
+  void steal (u8vec &o)
   {
-    CArray::iterator j = this->begin();
-    const uint8_t *str = __str.data()+__pos;
-    for(unsigned int i = this->size(); i > 0; i--,j++)
-        *j = *str++;
+    if (o.is_inline ())
+      {
+        memcpy (buf, o.buf, o.n);
+        n = o.n;
+      }
+    else
+      {
+        p = o.p;
+        n = o.n;
+        cap = o.cap;
+        o.p = o.buf;
+        o.cap = inline_size;
+      }
+    o.n = 0;
   }
-  CArray(const CArray& __str, size_type __pos, size_type __n) : u8vec(_min(__n,_sub(__pos,__str.size())))
+
+public:
+  u8vec() : p(buf), n(0), cap(inline_size) { }
+  explicit u8vec(size_type cnt) : u8vec() { resize (cnt); }
+  u8vec(size_type cnt, uint8_t val) : u8vec() { resize (cnt, val); }
+  template<class It, typename std::enable_if<!std::is_integral<It>::value, int>::type = 0>
+  u8vec(It first, It last) : u8vec() { assign (first, last); }
+  u8vec(std::initializer_list<uint8_t> l) : u8vec() { assign (l.begin(), l.end()); }
+  u8vec(const u8vec &o) : u8vec() { assign (o.begin(), o.end()); }
+  u8vec(u8vec &&o) noexcept : u8vec() { steal (o); }
+  ~u8vec() { release (); }
+
+  u8vec& operator= (const u8vec &o)
   {
-    CArray::iterator j = this->begin();
-    const uint8_t *str = __str.data()+__pos;
-    while(j != this->end())
-        *j++ = *str++;
+    if (this != &o)
+      assign (o.begin(), o.end());
+    return *this;
   }
-  CArray(const uint8_t *__str, size_type __pos, size_type __n) : u8vec(__n)
+  u8vec& operator= (u8vec &&o) noexcept
   {
-    CArray::iterator j = this->begin();
-    __str += __pos;
-    for(unsigned int i = __pos; j != this->end(); i++,j++)
-        *j = *__str++;
+    if (this != &o)
+      {
+        release ();
+        steal (o);
+      }
+    return *this;
   }
-  CArray(const uint8_t *__str, size_type __n) : u8vec(__n)
+  u8vec& operator= (std::initializer_list<uint8_t> l)
   {
-    CArray::iterator j = this->begin();
-    while(j != this->end())
-        *j++ = *__str++;
+    assign (l.begin(), l.end());
+    return *this;
   }
 
+  iterator begin () { return p; }
+  iterator end () { return p + n; }
+  const_iterator begin () const { return p; }
+  const_iterator end () const { return p + n; }
+  const_iterator cbegin () const { return p; }
+  const_iterator cend () const { return p + n; }
+  reverse_iterator rbegin () { return reverse_iterator (end ()); }
+  reverse_iterator rend () { return reverse_iterator (begin ()); }
+  const_reverse_iterator rbegin () const { return const_reverse_iterator (end ()); }
+  const_reverse_iterator rend () const { return const_reverse_iterator (begin ()); }
+
+  size_type size () const { return n; }
+  size_type capacity () const { return cap; }
+  size_type max_size () const { return 0xFFFFFFFF; }
+  bool empty () const { return n == 0; }
+  uint8_t *data () { return p; }
+  const uint8_t *data () const { return p; }
+
+  reference operator[] (size_type i) { return p[i]; }
+  const_reference operator[] (size_type i) const { return p[i]; }
+  reference at (size_type i)
+  {
+    if (i >= n)
+      throw std::out_of_range ("u8vec::at");
+    return p[i];
+  }
+  const_reference at (size_type i) const
+  {
+    if (i >= n)
+      throw std::out_of_range ("u8vec::at");
+    return p[i];
+  }
+  reference front () { return p[0]; }
+  const_reference front () const { return p[0]; }
+  reference back () { return p[n-1]; }
+  const_reference back () const { return p[n-1]; }
+
+  void reserve (size_type c) { grow (c); }
+  void shrink_to_fit () { }
+  void clear () { n = 0; }
+  void resize (size_type cnt, uint8_t val = 0)
+  {
+    grow (cnt);
+    if (cnt > n)
+      memset (p + n, val, cnt - n);
+    n = cnt;
+  }
+  void push_back (uint8_t val)
+  {
+    grow (n + 1);
+    p[n++] = val;
+  }
+  void emplace_back (uint8_t val) { push_back (val); }
+  void pop_back () { n--; }
+
+  void assign (size_type cnt, uint8_t val)
+  {
+    n = 0;
+    resize (cnt, val);
+  }
+  template<class It, typename std::enable_if<!std::is_integral<It>::value, int>::type = 0>
+  void assign (It first, It last)
+  {
+    n = 0;
+    insert (end (), first, last);
+  }
+
+  iterator insert (const_iterator pos, uint8_t val)
+  {
+    return insert (pos, 1, val);
+  }
+  iterator insert (const_iterator pos, size_type cnt, uint8_t val)
+  {
+    size_type off = pos - p;
+    grow (n + cnt);
+    memmove (p + off + cnt, p + off, n - off);
+    memset (p + off, val, cnt);
+    n += cnt;
+    return p + off;
+  }
+  iterator insert (const_iterator pos, const uint8_t *first, const uint8_t *last)
+  {
+    size_type off = pos - p;
+    size_type cnt = last - first;
+    if (first >= p && first < p + n)
+      {
+        // the source is part of this vector
+        u8vec tmp (first, last);
+        return insert (pos, tmp.cbegin(), tmp.cend());
+      }
+    grow (n + cnt);
+    memmove (p + off + cnt, p + off, n - off);
+    if (cnt)
+      memcpy (p + off, first, cnt);
+    n += cnt;
+    return p + off;
+  }
+  template<class It, typename std::enable_if<!std::is_integral<It>::value
+             && !std::is_convertible<It, const uint8_t *>::value, int>::type = 0>
+  iterator insert (const_iterator pos, It first, It last)
+  {
+    u8vec tmp;
+    for (; first != last; ++first)
+      tmp.push_back (*first);
+    return insert (pos, tmp.cbegin(), tmp.cend());
+  }
+  iterator erase (const_iterator pos)
+  {
+    return erase (pos, pos + 1);
+  }
+  iterator erase (const_iterator first, const_iterator last)
+  {
+    size_type off = first - p;
+    size_type cnt = last - first;
+    memmove (p + off, p + off + cnt, n - off - cnt);
+    n -= cnt;
+    return p + off;
+  }
+
+  void swap (u8vec &o)
+  {
+    u8vec tmp (std::move (o));
+    o = std::move (*this);
+    *this = std::move (tmp);
+  }
+};
+
+inline bool operator== (const u8vec &a, const u8vec &b)
+{
+  return a.size() == b.size() && !memcmp (a.data(), b.data(), a.size());
+}
+inline bool operator!= (const u8vec &a, const u8vec &b) { return !(a == b); }
+inline bool operator< (const u8vec &a, const u8vec &b)
+{
+  return std::lexicographical_compare (a.begin(), a.end(), b.begin(), b.end());
+}
+
+/** A read-only view of bytes owned by somebody else.
+  Parsers take one of these so that they can work directly on a receive
+  buffer, or on part of a packet, without copying it into a CArray first.
+  The view must not outlive the buffer it points to.
+  */
+class CArrayView
+{
+  const uint8_t *p;
+  size_t n;
+
+public:
+  typedef uint8_t value_type;
+  typedef size_t size_type;
+  typedef const uint8_t *const_iterator;
+  typedef const uint8_t *iterator;
+
+  CArrayView () : p(nullptr), n(0) { }
+  CArrayView (const uint8_t *data, size_t len) : p(data), n(len) { }
+  CArrayView (const u8vec &a) : p(a.data()), n(a.size()) { }
+
+  const uint8_t *data () const { return p; }
+  size_t size () const { return n; }
+  bool empty () const { return n == 0; }
+  const uint8_t &operator[] (size_t i) const { return p[i]; }
+  const uint8_t *begin () const { return p; }
+  const uint8_t *end () const { return p + n; }
+
+  /** the part starting at @pos, at most @cnt bytes long */
+  CArrayView sub (size_t pos, size_t cnt = SIZE_MAX) const
+  {
+    if (pos > n)
+      pos = n;
+    return CArrayView (p + pos, std::min (cnt, n - pos));
+  }
+};
+
+inline bool operator== (const CArrayView &a, const CArrayView &b)
+{
+  return a.size() == b.size() && !memcmp (a.data(), b.data(), a.size());
+}
+inline bool operator!= (const CArrayView &a, const CArrayView &b) { return !(a == b); }
+
+class CArray : public u8vec
+{
+public:
+  /** start with various initializers */
+  CArray() : u8vec() { }
+  CArray(const CArray& __str, size_type __pos)
+    : CArray(CArrayView(__str).sub(__pos)) { }
+  CArray(const CArray& __str, size_type __pos, size_type __n)
+    : CArray(CArrayView(__str).sub(__pos,__n)) { }
+  CArray(const uint8_t *__str, size_type __pos, size_type __n)
+    : u8vec(__str+__pos, __str+__pos+__n) { }
+  CArray(const uint8_t *__str, size_type __n) : u8vec(__str, __str+__n) { }
+  CArray(std::initializer_list<uint8_t> __l) : u8vec(__l) { }
+  explicit CArray(const CArrayView &__v) : u8vec(__v.begin(), __v.end()) { }
+
   /** set me to a C array */
   void set (const uint8_t *elem, unsigned cnt)
   {
-    this->resize(cnt);
-    CArray::iterator j = this->begin();
-    while(j != this->end())
-        *j++ = *elem++;
+    this->assign(elem, elem+cnt);
   }
 
   /** copy content. Should be equivalent to operator= */
   void set (const CArray & a)
   {
-    this->resize(a.size());
-    CArray::const_iterator i = a.begin();
-    CArray::iterator j = this->begin();
-    while (i != a.end())
-      *j++ = *i++;
+    this->assign(a.begin(), a.end());
   }
 
   /** replace a part of the array and resize to fit
@@ -123,10 +390,7 @@ public:
   {
     if (cnt + start > size())
       resize (cnt + start);
-
-    CArray::iterator i = this->begin()+start;
-    while(cnt--)
-        *i++ = *elem++;
+    memmove (this->data()+start, elem, cnt);
   }
 
   /** setpart for a string. This copies the terminal null character, */
@@ -138,13 +402,7 @@ public:
   /** why doesn't std::vector have this?? */
   void operator+= (const CArray &a)
   {
-    unsigned int off = this->size();
-    resize(this->size()+a.size());
-
-    CArray::const_iterator i = a.begin();
-    CArray::iterator j = this->begin()+off;
-    while (i != a.end())
-      *j++ = *i++;
+    this->insert(this->end(), a.begin(), a.end());
   }
 
   /** replace a part of the array with the content of a and resize to fit
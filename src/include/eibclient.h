@@ -868,6 +868,75 @@ int EIB_Cache_LastUpdates2 (EIBConnection * con, uint32_t start,
 			    uint8_t timeout, int max_len, uint8_t * buf,
 			    uint32_t * end);
 
+/** Start a dump of all group cache entries within a group address range.
+ * The entries are returned as a sequence of messages; this call returns
+ * the first one, use EIB_Cache_GetEntries to retrieve the rest.
+ * Each entry consists of source address (2 bytes), group address (2 bytes),
+ * APDU length (1 byte) and the APDU.
+ * \param con eibd connection
+ * \param start first group address to return
+ * \param end last group address to return
+ * \param max_len buffer size (at least 4096)
+ * \param buf buffer for the entries
+ * \return -1 if error, 0 if there are no more entries, else number of bytes read
+ */
+int EIB_Cache_Dump (EIBConnection * con, eibaddr_t start, eibaddr_t end,
+		    int max_len, uint8_t * buf);
+
+/** Query the last values sent to a list of group addresses.
+ * The entries are returned in the same format as by EIB_Cache_Dump;
+ * use EIB_Cache_GetEntries to retrieve the rest of the sequence.
+ * Addresses which are not cached (and not answered within the timeout)
+ * are returned with source address 0 and an empty APDU.
+ * \param con eibd connection
+ * \param dst_len length of the address list in bytes
+ * \param dst list of group addresses (2 bytes per address)
+ * \param timeout if non-zero, send A_GroupValue_Read for cache misses and wait this many seconds for answers
+ * \param age if non-zero, treat cached telegrams older than age seconds as missing
+ * \param max_len buffer size (at least 4096)
+ * \param buf buffer for the entries
+ * \return -1 if error, 0 if there are no more entries, else number of bytes read
+ */
+int EIB_Cache_ReadMulti (EIBConnection * con, int dst_len,
+			 const uint8_t * dst, uint8_t timeout, uint16_t age,
+			 int max_len, uint8_t * buf);
+
+/** Returns the next message of an EIB_Cache_Dump or EIB_Cache_ReadMulti sequence
+ * \param con eibd connection
+ * \param max_len buffer size (at least 4096)
+ * \param buf buffer for the entries
+ * \return -1 if error, 0 if there are no more entries, else number of bytes read
+ */
+int EIB_Cache_GetEntries (EIBConnection * con, int max_len, uint8_t * buf);
+
+/** Returns the recorded value history of a group address.
+ * Each record consists of sequence number (4 bytes), receive time
+ * (4 bytes, seconds since the epoch), source address (2 bytes),
+ * APDU length (1 byte) and the APDU, oldest record first.
+ * \param con eibd connection
+ * \param dst group address
+ * \param start only return records with a sequence number of at least start
+ * \param since only return records received at or after this time
+ * \param max_len buffer size
+ * \param buf buffer for the records
+ * \return -1 if error, else number of bytes read
+ */
+int EIB_Cache_History (EIBConnection * con, eibaddr_t dst, uint32_t start,
+		       uint32_t since, int max_len, uint8_t * buf);
+
+/** Subscribes to group cache updates.
+ * Afterwards, each matching update is delivered like a group socket
+ * packet; read them with EIBGetGroup_Src.
+ * \param con eibd connection
+ * \param ranges_len length of ranges
+ * \param ranges group address ranges, each as first and last address
+ * (2 bytes each); use 0x0000-0xFFFF for all addresses
+ * \param changes_only only report updates which change the cached value
+ * \return 0 if successful, -1 if error
+ */
+int EIB_Cache_Subscribe (EIBConnection * con, int ranges_len,
+			 const uint8_t * ranges, int changes_only);
+
 /** Enable Group Cache - asynchronous.
  * \param con eibd connection
  * \return 0 if started, -1 if error
@@ -934,6 +1003,64 @@ int EIB_Cache_LastUpdates2_async (EIBConnection * con, uint32_t start,
 				  uint8_t timeout, int max_len, uint8_t * buf,
 				  uint32_t * end);
 
+/** Start a dump of all group cache entries within a group address range - asynchronous.
+ * \param con eibd connection
+ * \param start first group address to return
+ * \param end last group address to return
+ * \param max_len buffer size (at least 4096)
+ * \param buf buffer for the entries
+ * \return 0 if started, -1 if error
+ */
+int EIB_Cache_Dump_async (EIBConnection * con, eibaddr_t start, eibaddr_t end,
+			  int max_len, uint8_t * buf);
+
+/** Query the last values sent to a list of group addresses - asynchronous.
+ * \param con eibd connection
+ * \param dst_len length of the address list in bytes
+ * \param dst list of group addresses (2 bytes per address)
+ * \param timeout if non-zero, send A_GroupValue_Read for cache misses and wait this many seconds for answers
+ * \param age if non-zero, treat cached telegrams older than age seconds as missing
+ * \param max_len buffer size (at least 4096)
+ * \param buf buffer for the entries
+ * \return 0 if started, -1 if error
+ */
+int EIB_Cache_ReadMulti_async (EIBConnection * con, int dst_len,
+			       const uint8_t * dst, uint8_t timeout,
+			       uint16_t age, int max_len, uint8_t * buf);
+
+/** Returns the next message of an EIB_Cache_Dump or EIB_Cache_ReadMulti sequence - asynchronous.
+ * \param con eibd connection
+ * \param max_len buffer size (at least 4096)
+ * \param buf buffer for the entries
+ * \return 0 if started, -1 if error
+ */
+int EIB_Cache_GetEntries_async (EIBConnection * con, int max_len,
+				uint8_t * buf);
+
+/** Returns the recorded value history of a group address - asynchronous.
+ * \param con eibd connection
+ * \param dst group address
+ * \param start only return records with a sequence number of at least start
+ * \param since only return records received at or after this time
+ * \param max_len buffer size
+ * \param buf buffer for the records
+ * \return 0 if started, -1 if error
+ */
+int EIB_Cache_History_async (EIBConnection * con, eibaddr_t dst,
+			     uint32_t start, uint32_t since, int max_len,
+			     uint8_t * buf);
+
+/** Subscribes to group cache updates - asynchronous.
+ * \param con eibd connection
+ * \param ranges_len length of ranges
+ * \param ranges group address ranges, each as first and last address
+ * (2 bytes each); use 0x0000-0xFFFF for all addresses
+ * \param changes_only only report updates which change the cached value
+ * \return 0 if started, -1 if error
+ */
+int EIB_Cache_Subscribe_async (EIBConnection * con, int ranges_len,
+			       const uint8_t * ranges, int changes_only);
+
 
 __END_DECLS
 #endif
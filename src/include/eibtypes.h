@@ -88,5 +88,12 @@
 #define EIB_CACHE_LAST_UPDATES          0x0076
 #define EIB_CACHE_LAST_UPDATES_2        0x0077
 // like last_updates but 32bit counter
+#define EIB_CACHE_DUMP                  0x0078
+#define EIB_CACHE_READ_MULTI            0x0079
+#define EIB_CACHE_ENTRIES               0x007A
+// a sequence of cache entries, terminated by an empty one
+#define EIB_CACHE_HISTORY               0x007B
+#define EIB_CACHE_SUBSCRIBE             0x007C
+// turns the connection into a stream of EIB_GROUP_PACKET cache updates
 
 #endif
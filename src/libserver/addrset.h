@@ -0,0 +1,76 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef EIB_ADDRSET_H
+#define EIB_ADDRSET_H
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "types.h"
+
+/** A set of individual addresses, as seen on a link.
+ *
+ * Most links only ever see a handful of addresses: a tunnel client, a
+ * routing peer with a couple of devices. These are kept in a short sorted
+ * array. A link with more addresses than that is a real bus segment, and
+ * gets a bitmap of the whole address space instead.
+ */
+class AddrSet
+{
+  /** beyond this many addresses we switch to the bitmap */
+  static const unsigned int max_small = 16;
+
+  std::vector<eibaddr_t> small;
+  std::unique_ptr<uint64_t[]> bits;
+
+public:
+  bool has (eibaddr_t addr) const
+    {
+      if (bits)
+        return (bits[addr >> 6] >> (addr & 63)) & 1;
+      return std::binary_search (small.begin(), small.end(), addr);
+    }
+
+  void add (eibaddr_t addr)
+    {
+      if (bits)
+        {
+          bits[addr >> 6] |= (uint64_t)1 << (addr & 63);
+          return;
+        }
+      auto i = std::lower_bound (small.begin(), small.end(), addr);
+      if (i != small.end() && *i == addr)
+        return;
+      if (small.size() < max_small)
+        {
+          small.insert (i, addr);
+          return;
+        }
+
+      bits.reset (new uint64_t[0x10000 / 64]());
+      for (eibaddr_t a : small)
+        bits[a >> 6] |= (uint64_t)1 << (a & 63);
+      std::vector<eibaddr_t> ().swap (small);
+      add (addr);
+    }
+};
+
+#endif
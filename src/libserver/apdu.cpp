@@ -21,157 +21,121 @@
 #include <string.h>
 #include "apdu.h"
 
+template<class T>
+static APDUPtr
+makeAPDU ()
+{
+  return APDUPtr(new T ());
+}
+
+/** maps an APCI pattern to the class which decodes it */
+struct APDUCodec
+{
+  /** APCI bits, i.e. the low two bits of the first and all of the second octet */
+  uint16_t apci;
+  /** which bits of apci are significant; the rest carry data */
+  uint16_t mask;
+  APDUPtr (*make) ();
+};
+
+/** All known services. To add one, add a line here. */
+static constexpr APDUCodec apduCodecs[] = {
+  { 0x000, 0x3C0, &makeAPDU<A_GroupValue_Read_PDU> },
+  { 0x040, 0x3C0, &makeAPDU<A_GroupValue_Response_PDU> },
+  { 0x080, 0x3C0, &makeAPDU<A_GroupValue_Write_PDU> },
+  { 0x0C0, 0x3C0, &makeAPDU<A_IndividualAddress_Write_PDU> },
+  { 0x100, 0x3C0, &makeAPDU<A_IndividualAddress_Read_PDU> },
+  { 0x140, 0x3C0, &makeAPDU<A_IndividualAddress_Response_PDU> },
+  { 0x180, 0x3C0, &makeAPDU<A_ADC_Read_PDU> },
+  { 0x1C0, 0x3C0, &makeAPDU<A_ADC_Response_PDU> },
+  { 0x200, 0x3C0, &makeAPDU<A_Memory_Read_PDU> },
+  { 0x240, 0x3C0, &makeAPDU<A_Memory_Response_PDU> },
+  { 0x280, 0x3C0, &makeAPDU<A_Memory_Write_PDU> },
+  { 0x2C0, 0x3FF, &makeAPDU<A_UserMemory_Read_PDU> },
+  { 0x2C1, 0x3FF, &makeAPDU<A_UserMemory_Response_PDU> },
+  { 0x2C2, 0x3FF, &makeAPDU<A_UserMemory_Write_PDU> },
+  { 0x2C4, 0x3FF, &makeAPDU<A_UserMemoryBit_Write_PDU> },
+  { 0x2C5, 0x3FF, &makeAPDU<A_UserManufacturerInfo_Read_PDU> },
+  { 0x2C6, 0x3FF, &makeAPDU<A_UserManufacturerInfo_Response_PDU> },
+  { 0x300, 0x3C0, &makeAPDU<A_DeviceDescriptor_Read_PDU> },
+  { 0x340, 0x3C0, &makeAPDU<A_DeviceDescriptor_Response_PDU> },
+  { 0x380, 0x3C0, &makeAPDU<A_Restart_PDU> },
+  { 0x3D0, 0x3FF, &makeAPDU<A_MemoryBit_Write_PDU> },
+  { 0x3D1, 0x3FF, &makeAPDU<A_Authorize_Request_PDU> },
+  { 0x3D2, 0x3FF, &makeAPDU<A_Authorize_Response_PDU> },
+  { 0x3D3, 0x3FF, &makeAPDU<A_Key_Write_PDU> },
+  { 0x3D4, 0x3FF, &makeAPDU<A_Key_Response_PDU> },
+  { 0x3D5, 0x3FF, &makeAPDU<A_PropertyValue_Read_PDU> },
+  { 0x3D6, 0x3FF, &makeAPDU<A_PropertyValue_Response_PDU> },
+  { 0x3D7, 0x3FF, &makeAPDU<A_PropertyValue_Write_PDU> },
+  { 0x3D8, 0x3FF, &makeAPDU<A_PropertyDescription_Read_PDU> },
+  { 0x3D9, 0x3FF, &makeAPDU<A_PropertyDescription_Response_PDU> },
+  { 0x3DC, 0x3FF, &makeAPDU<A_IndividualAddressSerialNumber_Read_PDU> },
+  { 0x3DD, 0x3FF, &makeAPDU<A_IndividualAddressSerialNumber_Response_PDU> },
+  { 0x3DE, 0x3FF, &makeAPDU<A_IndividualAddressSerialNumber_Write_PDU> },
+  { 0x3DF, 0x3FF, &makeAPDU<A_ServiceInformation_Indication_Write_PDU> },
+  { 0x3E0, 0x3FF, &makeAPDU<A_DomainAddress_Write_PDU> },
+  { 0x3E1, 0x3FF, &makeAPDU<A_DomainAddress_Read_PDU> },
+  { 0x3E2, 0x3FF, &makeAPDU<A_DomainAddress_Response_PDU> },
+  { 0x3E3, 0x3FF, &makeAPDU<A_DomainAddressSelective_Read_PDU> },
+};
+
+#define N_APDU_CODECS (sizeof (apduCodecs) / sizeof (apduCodecs[0]))
+
+static constexpr bool
+codecValid (size_t i)
+{
+  return apduCodecs[i].mask <= 0x3FF && !(apduCodecs[i].apci & ~apduCodecs[i].mask);
+}
+
+static constexpr bool
+codecsOverlap (size_t i, size_t j)
+{
+  return !((apduCodecs[i].apci ^ apduCodecs[j].apci)
+           & apduCodecs[i].mask & apduCodecs[j].mask);
+}
+
+static constexpr bool
+codecDisjoint (size_t i, size_t j)
+{
+  return j >= N_APDU_CODECS || (!codecsOverlap (i, j) && codecDisjoint (i, j + 1));
+}
+
+static constexpr bool
+codecsValid (size_t i)
+{
+  return i >= N_APDU_CODECS
+    || (codecValid (i) && codecDisjoint (i, i + 1) && codecsValid (i + 1));
+}
+
+static_assert (codecsValid (0), "apduCodecs: an entry is malformed or overlaps another one");
+
+/** apduCodecs, expanded to all 1024 APCI values */
+static const struct APDUDispatch
+{
+  APDUPtr (*make[0x400]) ();
+
+  APDUDispatch ()
+  {
+    for (unsigned int apci = 0; apci < 0x400; apci++)
+      {
+        make[apci] = nullptr;
+        for (size_t i = 0; i < N_APDU_CODECS; i++)
+          if ((apci & apduCodecs[i].mask) == apduCodecs[i].apci)
+            make[apci] = apduCodecs[i].make;
+      }
+  }
+} apduDispatch;
+
 APDUPtr
 APDU::fromPacket (const CArray & c, TracePtr tr)
 {
   APDUPtr a;
   if (c.size() >= 2)
     {
-      switch (c[0] & 0x03)
-	{
-	case 0:
-	  switch (c[1] & 0xC0)
-	    {
-	    case 0x00:
-	      a = APDUPtr(new A_GroupValue_Read_PDU ());
-	      break;
-	    case 0x40:
-	      a = APDUPtr(new A_GroupValue_Response_PDU ());
-	      break;
-	    case 0x80:
-	      a = APDUPtr(new A_GroupValue_Write_PDU ());
-	      break;
-	    case 0xC0:
-	      a = APDUPtr(new A_IndividualAddress_Write_PDU ());
-	      break;
-	    }
-	  break;
-	case 1:
-	  switch (c[1] & 0xC0)
-	    {
-	    case 0x00:
-	      a = APDUPtr(new A_IndividualAddress_Read_PDU ());
-	      break;
-	    case 0x40:
-	      a = APDUPtr(new A_IndividualAddress_Response_PDU ());
-	      break;
-	    case 0x80:
-	      a = APDUPtr(new A_ADC_Read_PDU ());
-	      break;
-	    case 0xC0:
-	      a = APDUPtr(new A_ADC_Response_PDU ());
-	      break;
-	    }
-	  break;
-	case 2:
-	  switch (c[1] & 0xC0)
-	    {
-	    case 0x00:
-	      a = APDUPtr(new A_Memory_Read_PDU ());
-	      break;
-	    case 0x40:
-	      a = APDUPtr(new A_Memory_Response_PDU ());
-	      break;
-	    case 0x80:
-	      a = APDUPtr(new A_Memory_Write_PDU ());
-	      break;
-	    case 0xC0:
-	      switch (c[1])
-		{
-		case 0xC0:
-		  a = APDUPtr(new A_UserMemory_Read_PDU ());
-		  break;
-		case 0xC1:
-		  a = APDUPtr(new A_UserMemory_Response_PDU ());
-		  break;
-		case 0xC2:
-		  a = APDUPtr(new A_UserMemory_Write_PDU ());
-		  break;
-		case 0xC4:
-		  a = APDUPtr(new A_UserMemoryBit_Write_PDU ());
-		  break;
-		case 0xC5:
-		  a = APDUPtr(new A_UserManufacturerInfo_Read_PDU ());
-		  break;
-		case 0xC6:
-		  a = APDUPtr(new A_UserManufacturerInfo_Response_PDU ());
-		  break;
-		}
-	    }
-	  break;
-	case 3:
-	  switch (c[1] & 0xC0)
-	    {
-	    case 0x00:
-	      a = APDUPtr(new A_DeviceDescriptor_Read_PDU ());
-	      break;
-	    case 0x40:
-	      a = APDUPtr(new A_DeviceDescriptor_Response_PDU ());
-	      break;
-	    case 0x80:
-	      a = APDUPtr(new A_Restart_PDU ());
-	      break;
-	    case 0xC0:
-	      switch (c[1])
-		{
-		case 0xD0:
-		  a = APDUPtr(new A_MemoryBit_Write_PDU ());
-		  break;
-		case 0xD1:
-		  a = APDUPtr(new A_Authorize_Request_PDU ());
-		  break;
-		case 0xD2:
-		  a = APDUPtr(new A_Authorize_Response_PDU ());
-		  break;
-		case 0xD3:
-		  a = APDUPtr(new A_Key_Write_PDU ());
-		  break;
-		case 0xD4:
-		  a = APDUPtr(new A_Key_Response_PDU ());
-		  break;
-		case 0xD5:
-		  a = APDUPtr(new A_PropertyValue_Read_PDU ());
-		  break;
-		case 0xD6:
-		  a = APDUPtr(new A_PropertyValue_Response_PDU ());
-		  break;
-		case 0xD7:
-		  a = APDUPtr(new A_PropertyValue_Write_PDU ());
-		  break;
-		case 0xD8:
-		  a = APDUPtr(new A_PropertyDescription_Read_PDU ());
-		  break;
-		case 0xD9:
-		  a = APDUPtr(new A_PropertyDescription_Response_PDU ());
-		  break;
-		case 0xDC:
-		  a = APDUPtr(new A_IndividualAddressSerialNumber_Read_PDU ());
-		  break;
-		case 0xDD:
-		  a = APDUPtr(new A_IndividualAddressSerialNumber_Response_PDU ());
-		  break;
-		case 0xDE:
-		  a = APDUPtr(new A_IndividualAddressSerialNumber_Write_PDU ());
-		  break;
-		case 0xDF:
-		  a = APDUPtr(new A_ServiceInformation_Indication_Write_PDU ());
-		  break;
-		case 0xE0:
-		  a = APDUPtr(new A_DomainAddress_Write_PDU ());
-		  break;
-		case 0xE1:
-		  a = APDUPtr(new A_DomainAddress_Read_PDU ());
-		  break;
-		case 0xE2:
-		  a = APDUPtr(new A_DomainAddress_Response_PDU ());
-		  break;
-		case 0xE3:
-		  a = APDUPtr(new A_DomainAddressSelective_Read_PDU ());
-		  break;
-		}
-	    }
-	  break;
-	}
+      APDUPtr (*make) () = apduDispatch.make[((c[0] & 0x03) << 8) | c[1]];
+      if (make)
+        a = make ();
     }
   if (a && a->init (c, tr))
     return a;
@@ -0,0 +1,242 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <new>
+#include <string>
+
+#include "asynclog.h"
+
+AsyncLog&
+AsyncLog::instance()
+{
+  static AsyncLog log;
+  return log;
+}
+
+void
+AsyncLog::setup (unsigned int n)
+{
+  std::lock_guard<std::mutex> g(lock);
+  if (slots)
+    return;
+
+  size_t size = 16;
+  while (size < n && size < 65536)
+    size <<= 1;
+  slots = std::unique_ptr<Slot[]>(new Slot[size]);
+  mask = size - 1;
+  reset();
+
+  sem_init (&ready, 0, 0);
+  pthread_atfork (nullptr, nullptr, atfork_child);
+}
+
+void
+AsyncLog::reset ()
+{
+  for (size_t i = 0; i <= mask; i++)
+    slots[i].seq.store (i, std::memory_order_relaxed);
+  head.store (0, std::memory_order_relaxed);
+  tail = 0;
+  dropped.store (0, std::memory_order_relaxed);
+}
+
+void
+AsyncLog::atfork_child ()
+{
+  /* The writer thread didn't survive the fork. Whatever is still queued
+   * belongs to the parent, which writes it itself. */
+  AsyncLog &log = instance();
+  new (&log.lock) std::mutex();
+  sem_destroy (&log.ready);
+  sem_init (&log.ready, 0, 0);
+  log.reset();
+  log.running.store (false);
+}
+
+void
+AsyncLog::start ()
+{
+  std::lock_guard<std::mutex> g(lock);
+  if (running.load() || stopping.load())
+    return;
+  if (pthread_create (&writer, nullptr, run_writer, this) == 0)
+    running.store (true);
+}
+
+/** a reserve() which didn't get a slot because there is no ring */
+#define DIRECT ((size_t)-1)
+
+bool
+AsyncLog::reserve (Msg &m, int fd)
+{
+  m.fd = fd;
+  if (!slots || stopping.load (std::memory_order_relaxed))
+    {
+      static thread_local char direct[slot_size];
+      m.data = direct;
+      m.pos = DIRECT;
+      return true;
+    }
+  if (!running.load (std::memory_order_relaxed))
+    start();
+
+  Slot *s;
+  size_t pos = head.load (std::memory_order_relaxed);
+  for (;;)
+    {
+      s = &slots[pos & mask];
+      size_t seq = s->seq.load (std::memory_order_acquire);
+      intptr_t dif = (intptr_t) seq - (intptr_t) pos;
+      if (dif == 0)
+        {
+          if (head.compare_exchange_weak (pos, pos + 1,
+                                          std::memory_order_relaxed))
+            break;
+        }
+      else if (dif < 0)
+        {
+          dropped.fetch_add (1, std::memory_order_relaxed);
+          return false;
+        }
+      else
+        pos = head.load (std::memory_order_relaxed);
+    }
+  m.data = s->data;
+  m.pos = pos;
+  return true;
+}
+
+void
+AsyncLog::commit (Msg &m, size_t len)
+{
+  if (m.pos == DIRECT)
+    {
+      while (::write (m.fd, m.data, len) < 0 && errno == EINTR)
+        ;
+      return;
+    }
+  Slot *s = &slots[m.pos & mask];
+  s->len = len;
+  s->fd = m.fd;
+  s->seq.store (m.pos + 1, std::memory_order_release);
+  sem_post (&ready);
+}
+
+void
+AsyncLog::write (int fd, const char *msg, size_t len)
+{
+  Msg m;
+  if (!reserve (m, fd))
+    return;
+  if (len > slot_size)
+    {
+      len = slot_size;
+      memcpy (m.data, msg, len - 1);
+      m.data[len - 1] = '\n';
+    }
+  else
+    memcpy (m.data, msg, len);
+  commit (m, len);
+}
+
+static void
+write_all (int fd, const char *buf, size_t len)
+{
+  while (len > 0)
+    {
+      ssize_t n = ::write (fd, buf, len);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return; // nowhere to complain to
+        }
+      buf += n;
+      len -= n;
+    }
+}
+
+void *
+AsyncLog::run_writer (void *arg)
+{
+  static_cast<AsyncLog *>(arg)->run();
+  return nullptr;
+}
+
+void
+AsyncLog::run ()
+{
+  /* Collect consecutive messages to the same fd into one write() */
+  std::string buf;
+  int buf_fd = -1;
+  buf.reserve (16 * slot_size);
+
+  for (;;)
+    {
+      while (sem_wait (&ready) < 0 && errno == EINTR)
+        ;
+
+      for (;;)
+        {
+          Slot &s = slots[tail & mask];
+          if (s.seq.load (std::memory_order_acquire) != tail + 1)
+            break;
+
+          unsigned long lost = dropped.exchange (0, std::memory_order_relaxed);
+          if (lost)
+            {
+              write_all (buf_fd, buf.data(), buf.size());
+              buf.clear();
+              std::string m = "knxd: " + std::to_string (lost)
+                              + " log messages dropped\n";
+              write_all (2, m.data(), m.size());
+            }
+          if (s.fd != buf_fd || buf.size() + s.len > buf.capacity())
+            {
+              write_all (buf_fd, buf.data(), buf.size());
+              buf.clear();
+              buf_fd = s.fd;
+            }
+          buf.append (s.data, s.len);
+
+          s.seq.store (tail + mask + 1, std::memory_order_release);
+          tail++;
+        }
+      write_all (buf_fd, buf.data(), buf.size());
+      buf.clear();
+
+      if (stopping.load())
+        break;
+    }
+}
+
+AsyncLog::~AsyncLog ()
+{
+  /* Write whatever is still queued before exiting */
+  stopping.store (true);
+  if (running.load())
+    {
+      sem_post (&ready);
+      pthread_join (writer, nullptr);
+    }
+}
@@ -0,0 +1,108 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef ASYNCLOG_H
+#define ASYNCLOG_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <semaphore.h>
+
+/** Trace output which doesn't block the event loop.
+ *
+ * Messages are copied into a preallocated ring of fixed-size slots and
+ * written to stdout/stderr by a separate thread. Queueing a message never
+ * waits: when the ring is full the message is dropped and counted, and
+ * the writer reports the number of lost messages before the next one.
+ *
+ * There is one ring per process. It is sized by the first debug section
+ * which enables "async-log", and the writer is (re)started on first use,
+ * so this survives knxd's fork into the background.
+ */
+class AsyncLog
+{
+public:
+  /** message size limit; longer ones are truncated */
+  static const unsigned int slot_size = 1024;
+
+  static AsyncLog& instance();
+
+  /** Allocate the ring. Only the first call has any effect. */
+  void setup (unsigned int slots);
+
+  /** queue a message for file descriptor fd (1 or 2) */
+  void write (int fd, const char *msg, size_t len);
+
+  /** a message which is built in place, see reserve() */
+  struct Msg
+  {
+    /** room for slot_size bytes */
+    char *data;
+    size_t pos;
+    int fd;
+  };
+
+  /** Reserve a slot for a message to fd, so that the caller can format
+   * it directly into m.data. Every successful reserve() must be followed
+   * by a commit().
+   * @return false if the ring is full; the message is counted as lost. */
+  bool reserve (Msg &m, int fd);
+  /** queue the first len bytes of m.data */
+  void commit (Msg &m, size_t len);
+
+  ~AsyncLog ();
+
+private:
+  struct Slot
+  {
+    /** sequence number: pos = free for writing at pos, pos+1 = filled */
+    std::atomic<size_t> seq;
+    uint16_t len;
+    uint8_t fd;
+    char data[slot_size];
+  };
+
+  AsyncLog () { }
+
+  std::unique_ptr<Slot[]> slots;
+  size_t mask = 0;
+
+  /** next slot to fill; shared by all producers */
+  std::atomic<size_t> head {0};
+  /** next slot to write; owned by the writer thread */
+  size_t tail = 0;
+  /** messages lost since the last report */
+  std::atomic<unsigned long> dropped {0};
+
+  std::mutex lock;
+  sem_t ready;
+  pthread_t writer;
+  std::atomic<bool> running {false};
+  std::atomic<bool> stopping {false};
+
+  void reset ();
+  void start ();
+  void run ();
+  static void *run_writer (void *arg);
+  static void atfork_child ();
+};
+
+#endif
@@ -0,0 +1,164 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "bintrace.h"
+
+#define BT_HDRSIZE 4096
+#define BT_STRTABSIZE 65536
+#define BT_MINRING 65536
+
+BinTrace&
+BinTrace::instance()
+{
+  static BinTrace bt;
+  return bt;
+}
+
+bool
+BinTrace::open (const std::string& path, size_t size)
+{
+  std::lock_guard<std::mutex> g(lock);
+  if (ring)
+    return true;
+
+  size_t ring_size = size > BT_HDRSIZE + BT_STRTABSIZE + BT_MINRING
+                     ? size - BT_HDRSIZE - BT_STRTABSIZE : BT_MINRING;
+  ring_size &= ~(size_t)7;
+  map_size = BT_HDRSIZE + BT_STRTABSIZE + ring_size;
+
+  /* keep the previous run's trace, it may explain why we're restarting */
+  rename (path.c_str(), (path + ".old").c_str());
+
+  fd = ::open (path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+  if (fd < 0)
+    return false;
+  if (ftruncate (fd, map_size) < 0)
+    goto err;
+  map = (uint8_t *) mmap (nullptr, map_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED)
+    {
+      map = nullptr;
+      goto err;
+    }
+
+  hdr = (BinTraceHeader *) map;
+  memcpy (hdr->magic, BINTRACE_MAGIC, sizeof(hdr->magic));
+  hdr->version = BINTRACE_VERSION;
+  hdr->hdr_size = BT_HDRSIZE;
+  hdr->strtab_size = BT_STRTABSIZE;
+  hdr->strtab_used = 0;
+  hdr->ring_size = ring_size;
+  hdr->head = 0;
+  hdr->tail = 0;
+  strtab = map + BT_HDRSIZE;
+  ring = strtab + BT_STRTABSIZE;
+  return true;
+
+err:
+  close (fd);
+  fd = -1;
+  return false;
+}
+
+BinTrace::~BinTrace ()
+{
+  if (map)
+    munmap (map, map_size);
+  if (fd >= 0)
+    close (fd);
+}
+
+uint32_t
+BinTrace::intern (const char *fmt)
+{
+  auto i = ids.find (fmt);
+  if (i != ids.end() && !strcmp ((const char *) strtab + i->second + 2, fmt))
+    return i->second;
+
+  std::string text (fmt);
+  auto t = ids_by_text.find (text);
+  if (t != ids_by_text.end())
+    {
+      ids[fmt] = t->second;
+      return t->second;
+    }
+
+  size_t len = text.size();
+  uint32_t id = hdr->strtab_used;
+  if (len > 0xFFFF || id + 3 + len > hdr->strtab_size)
+    return BT_NOFMT;
+
+  uint16_t l = len;
+  memcpy (strtab + id, &l, 2);
+  memcpy (strtab + id + 2, fmt, len + 1);
+  hdr->strtab_used = id + 3 + len;
+  ids[fmt] = id;
+  ids_by_text[text] = id;
+  return id;
+}
+
+void
+BinTrace::commit (BinTraceEncoder& e, const char *fmt, size_t at)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_REALTIME, &ts);
+
+  BinTraceRecord *r = (BinTraceRecord *) e.buf;
+  r->time = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+
+  std::lock_guard<std::mutex> g(lock);
+  r->fmt = intern (fmt);
+  if (r->fmt == BT_NOFMT)
+    e.insert (at, fmt);
+  r->len = (e.len + 7) & ~7;
+
+  uint64_t size = hdr->ring_size;
+  uint64_t head = hdr->head;
+  size_t pos = head % size;
+  size_t need = r->len;
+  size_t pad = 0;
+  if (pos + need > size)
+    pad = size - pos;
+
+  /* drop the oldest records to make room */
+  while (head + pad + need - hdr->tail > size)
+    {
+      BinTraceRecord *old = (BinTraceRecord *) (ring + hdr->tail % size);
+      hdr->tail += old->len;
+    }
+
+  if (pad)
+    {
+      BinTraceRecord *p = (BinTraceRecord *) (ring + pos);
+      p->len = pad;
+      p->type = BT_PAD;
+      head += pad;
+      pos = 0;
+    }
+  memcpy (ring + pos, e.buf, e.len);
+  memset (ring + pos + e.len, 0, need - e.len);
+  hdr->head = head + need;
+}
@@ -0,0 +1,235 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/**
+
+Structured trace records.
+
+Instead of formatting trace messages into text, this writes the format
+string's ID, the arguments (tagged by type) and a timestamp to a file
+which is mapped into memory. The format strings are stored in that file
+once. knxd-tracefmt renders the records as text, so formatting happens
+offline and only if somebody actually looks at the trace.
+
+The records are kept in a ring buffer, i.e. the file has a fixed size and
+always holds the most recent messages. As it's a shared mapping, it
+survives a crash of knxd.
+
+File layout: a header (BinTraceHeader), the string table, and the ring.
+The string table holds a 16-bit length, the string, and a NUL byte per
+entry; a format's ID is its offset. Records (BinTraceRecord) are aligned
+to 8 bytes and never wrap; a BT_PAD record fills the end of the ring
+instead. Each argument is a tag byte followed by its value:
+
+  'i' int64, 'u' uint64, 'p' pointer (uint64), 'd' double,
+  's' string, 'b' blob (16-bit length, then the data)
+
+All numbers are in host byte order.
+*/
+
+#ifndef BINTRACE_H
+#define BINTRACE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+#define BINTRACE_MAGIC "KNXDTRC1"
+#define BINTRACE_VERSION 1
+
+/** the format string is stored in the record, as the first 's' argument */
+#define BT_NOFMT 0xFFFFFFFF
+
+/** maximum record size; longer ones are truncated */
+#define BT_MAXREC 1024
+
+struct BinTraceHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t hdr_size;
+  uint32_t strtab_size;
+  uint32_t strtab_used;
+  uint64_t ring_size;
+  /** total number of bytes written to the ring */
+  uint64_t head;
+  /** start of the oldest record, in the same units as head */
+  uint64_t tail;
+};
+
+enum BinTraceType
+{
+  BT_PAD = 0,
+  /** TracePrintf(); args: name, message arguments */
+  BT_TRACE,
+  /** TracePacket(); args: name, data as 'b' */
+  BT_PACKET,
+  /** ErrorPrintf(); args: name, message arguments */
+  BT_ERROR,
+};
+
+struct BinTraceRecord
+{
+  /** total length, including this header */
+  uint16_t len;
+  uint8_t type;
+  /** trace layer, error level */
+  uint8_t layer;
+  uint32_t fmt;
+  /** CLOCK_REALTIME, nsec */
+  uint64_t time;
+  /** Trace::seq */
+  uint32_t seq;
+  /** error message ID */
+  uint32_t msgid;
+};
+
+/** builds one record */
+class BinTraceEncoder
+{
+public:
+  uint8_t buf[BT_MAXREC];
+  size_t len = sizeof(BinTraceRecord);
+
+  void put (uint8_t tag, const void *p, size_t n)
+    {
+      if (len + 1 + n > sizeof(buf))
+        return;
+      buf[len] = tag;
+      memcpy (buf + len + 1, p, n);
+      len += 1 + n;
+    }
+  void data (uint8_t tag, const void *p, size_t n)
+    {
+      if (len + 3 > sizeof(buf))
+        return;
+      if (n > sizeof(buf) - len - 3)
+        n = sizeof(buf) - len - 3;
+      uint16_t l = n;
+      buf[len] = tag;
+      memcpy (buf + len + 1, &l, 2);
+      memcpy (buf + len + 3, p, n);
+      len += 3 + n;
+    }
+  /** insert a string argument at offset @at, moving what follows */
+  void insert (size_t at, const char *s)
+    {
+      if (len + 3 > sizeof(buf))
+        return;
+      size_t n = strlen (s);
+      if (n > sizeof(buf) - len - 3)
+        n = sizeof(buf) - len - 3;
+      uint16_t l = n;
+      memmove (buf + at + 3 + n, buf + at, len - at);
+      buf[at] = 's';
+      memcpy (buf + at + 1, &l, 2);
+      memcpy (buf + at + 3, s, n);
+      len += 3 + n;
+    }
+
+  void arg (const std::string& s) { data ('s', s.data(), s.size()); }
+  void arg (const char *s) { data ('s', s ? s : "(null)", s ? strlen(s) : 6); }
+  void arg (const void *p) { uint64_t x = (uintptr_t) p; put ('p', &x, 8); }
+  void arg (double d) { put ('d', &d, 8); }
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+  arg (T v) { int64_t x = v; put ('i', &x, 8); }
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+  arg (T v) { uint64_t x = v; put ('u', &x, 8); }
+  template<typename T>
+  typename std::enable_if<std::is_enum<T>::value>::type
+  arg (T v) { int64_t x = v; put ('i', &x, 8); }
+};
+
+/** The process's binary trace file */
+class BinTrace
+{
+  std::mutex lock;
+  int fd = -1;
+  uint8_t *map = nullptr;
+  size_t map_size = 0;
+  BinTraceHeader *hdr = nullptr;
+  uint8_t *strtab = nullptr;
+  uint8_t *ring = nullptr;
+  /** format string → ID. The key is the address, for speed, but some
+   * callers build their message in a buffer on the stack, so intern()
+   * checks that the string there is still the same. */
+  std::unordered_map<const void *, uint32_t> ids;
+  /** … and falls back to this one if it is not */
+  std::unordered_map<std::string, uint32_t> ids_by_text;
+
+  BinTrace () { }
+  /** the caller holds the lock */
+  uint32_t intern (const char *fmt);
+  /** Intern @fmt and append the record to the ring, under one lock. If
+   * the string table is full, the format string is inserted as an
+   * argument at offset @at, i.e. right after the name. */
+  void commit (BinTraceEncoder& e, const char *fmt, size_t at);
+
+public:
+  static BinTrace& instance();
+  ~BinTrace ();
+
+  /** Create the file. Only the first call has any effect.
+   * @return false if that didn't work. */
+  bool open (const std::string& path, size_t size);
+
+  template <typename... Args>
+  void record (BinTraceType type, int layer, unsigned int seq,
+               unsigned int msgid, const std::string& name,
+               const char *fmt, const Args & ... args)
+    {
+      if (!ring)
+        return;
+      BinTraceEncoder e;
+      BinTraceRecord *r = (BinTraceRecord *) e.buf;
+      r->type = type;
+      r->layer = layer;
+      r->seq = seq;
+      r->msgid = msgid;
+      e.arg (name);
+      size_t at = e.len;
+      int dummy[] = { 0, (e.arg (args), 0)... };
+      (void) dummy;
+      commit (e, fmt, at);
+    }
+
+  void packet (int layer, unsigned int seq, const std::string& name,
+               const char *msg, const uint8_t *data, size_t len)
+    {
+      if (!ring)
+        return;
+      BinTraceEncoder e;
+      BinTraceRecord *r = (BinTraceRecord *) e.buf;
+      r->type = BT_PACKET;
+      r->layer = layer;
+      r->seq = seq;
+      r->msgid = 0;
+      e.arg (name);
+      size_t at = e.len;
+      e.data ('b', data, len);
+      commit (e, msg, at);
+    }
+};
+
+#endif
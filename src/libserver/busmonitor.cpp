@@ -55,7 +55,6 @@ A_Busmonitor::stop()
 A_Busmonitor::A_Busmonitor (ClientConnPtr c, bool virt, bool TS)
   : L_Busmonitor_CallBack(c->t->name),A__Base(c),router(static_cast<Router&>(c->server->router))
 {
-  t = TracePtr(new Trace(*c->t));
   t->setAuxName("BusMon");
   TRACEPRINTF (t, 7, "Open A_Busmonitor");
   con = c;
@@ -93,38 +92,43 @@ A_Busmonitor::setup (uint8_t *buf, size_t len)
 }
 
 void
-A_Busmonitor::send_L_Busmonitor (LBusmonPtr p)
+A_Busmonitor::send_L_Busmonitor (const L_Busmonitor_PDU &p)
 {
-  CArray buf;
-  if (ts)
+  CArray &buf = p.client_msg[ts ? BM_TS : BM_RAW];
+  if (buf.empty ())
     {
-      buf.resize (7);
-      EIBSETTYPE (buf, EIB_BUSMONITOR_PACKET_TS);
-      buf[2] = p->status;
-      buf[3] = (p->timestamp >> 24) & 0xff;
-      buf[4] = (p->timestamp >> 16) & 0xff;
-      buf[5] = (p->timestamp >> 8) & 0xff;
-      buf[6] = (p->timestamp) & 0xff;
-    }
-  else
-    {
-      buf.resize (2);
-      EIBSETTYPE (buf, EIB_BUSMONITOR_PACKET);
+      if (ts)
+        {
+          buf.resize (7);
+          EIBSETTYPE (buf, EIB_BUSMONITOR_PACKET_TS);
+          buf[2] = p.status;
+          buf[3] = (p.timestamp >> 24) & 0xff;
+          buf[4] = (p.timestamp >> 16) & 0xff;
+          buf[5] = (p.timestamp >> 8) & 0xff;
+          buf[6] = (p.timestamp) & 0xff;
+        }
+      else
+        {
+          buf.resize (2);
+          EIBSETTYPE (buf, EIB_BUSMONITOR_PACKET);
+        }
+      buf += p.pdu;
     }
-  buf += p->pdu;
 
   con->sendmessage (buf.size(), buf.data());
 }
 
 void
-A_Text_Busmonitor::send_L_Busmonitor (LBusmonPtr p)
+A_Text_Busmonitor::send_L_Busmonitor (const L_Busmonitor_PDU &p)
 {
-  CArray buf;
-  String s = p->Decode (t);
-  buf.resize (2 + s.length() + 1);
-  EIBSETTYPE (buf, EIB_BUSMONITOR_PACKET);
-  buf.setpart ((uint8_t *)s.c_str(), 2, s.length()+1);
+  CArray &buf = p.client_msg[BM_TEXT];
+  if (buf.empty ())
+    {
+      const String &s = p.text (t);
+      buf.resize (2 + s.length() + 1);
+      EIBSETTYPE (buf, EIB_BUSMONITOR_PACKET);
+      buf.setpart ((uint8_t *)s.c_str(), 2, s.length()+1);
+    }
 
   con->sendmessage (buf.size(), buf.data());
 }
-
@@ -25,6 +25,14 @@
 #include "client.h"
 #include "connection.h"
 
+/** Busmonitor message formats, indexing L_Busmonitor_PDU::client_msg */
+enum
+{
+  BM_RAW,
+  BM_TS,
+  BM_TEXT,
+};
+
 /** implements busmonitor functions for a client */
 class A_Busmonitor:public L_Busmonitor_CallBack, public A__Base
 {
@@ -38,8 +46,6 @@ class A_Busmonitor:public L_Busmonitor_CallBack, public A__Base
 protected:
   /** Layer 3 Interface*/
   Router& router;
-  /** debug output */
-  TracePtr t;
 public:
   /** initializes busmonitor
    * @param c client connection
@@ -55,7 +61,7 @@ public:
   void start();
   void stop();
 
-  void send_L_Busmonitor (LBusmonPtr l);
+  void send_L_Busmonitor (const L_Busmonitor_PDU &l);
   // dummy method
   void recv_Data(uint8_t *buf UNUSED, size_t len UNUSED) {}
 };
@@ -75,7 +81,7 @@ public:
   {
     t->setAuxName("TBusMon");
   }
-  void send_L_Busmonitor (LBusmonPtr l);
+  void send_L_Busmonitor (const L_Busmonitor_PDU &l);
 };
 
 #endif
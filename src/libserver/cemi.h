@@ -44,12 +44,12 @@ protected:
   enum { N_bad, N_up, N_down, N_open, N_reset } sendLocal_done_next = N_bad;
 
 private:
-  ev::timer reset_timer;
+  ev::timer reset_timer {loop};
   void reset_timer_cb(ev::timer &w, int revents);
 
   virtual CArray lData2EMI (uchar code, const LDataPtr &p) 
   { return L_Data_ToCEMI(code, p); }
-  virtual LDataPtr EMI2lData (const CArray & data) 
+  virtual LDataPtr EMI2lData (CArrayView data) 
   { return CEMI_to_L_Data(data, t); }
 
 public:
@@ -35,8 +35,7 @@
 
 ClientConnection::ClientConnection (NetServerPtr s, int fd) : router(static_cast<Router&>(s->router)), sendbuf(fd),recvbuf(fd)
 {
-  t = TracePtr(new Trace(*(s->t)));
-  t->setAuxName("CConn");
+  t = Trace::sub(s->t, "", "CConn");
   server = s;
 
   TRACEPRINTF (t, 8, "ClientConnection Init");
@@ -241,8 +240,14 @@ ClientConnection::read_cb (uint8_t *buf, size_t len)
     case EIB_CACHE_READ_NOWAIT:
     case EIB_CACHE_LAST_UPDATES:
     case EIB_CACHE_LAST_UPDATES_2:
+    case EIB_CACHE_DUMP:
+    case EIB_CACHE_READ_MULTI:
+    case EIB_CACHE_HISTORY:
       GroupCacheRequest (SFT, buf,xlen);
       break;
+    case EIB_CACHE_SUBSCRIBE:
+      a_conn = new A_CacheSubscription (SFT);
+      goto new_a_conn;
 #endif
 
     case EIB_RESET_CONNECTION:
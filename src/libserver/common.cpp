@@ -23,6 +23,8 @@
 #include <sys/time.h>
 #endif
 
+thread_local LOOP_RESULT loop;
+
 timestamp_t
 getTime ()
 {
@@ -93,7 +93,10 @@ inline T ignore_result(T x __attribute__((unused)))
 #else
   typedef int LOOP_RESULT;
 #endif
-extern LOOP_RESULT loop;
+/** The current thread's event loop. This is the default loop, except in
+ * the threads which run routing domains. Watchers are bound to it when
+ * they are created, thus "ev::timer timer {loop};". */
+extern thread_local LOOP_RESULT loop;
 
 
 #endif
@@ -29,7 +29,7 @@ public:
   TracePtr t;
   A__Base(ClientConnPtr cc)
     {
-      t = TracePtr(new Trace(*(cc->t), cc->t->name+'@'+FormatEIBAddr(cc->addr)));
+      t = Trace::sub(cc->t, cc->t->name+'@'+FormatEIBAddr(cc->addr));
       con = cc;
       on_error.set<A__Base,&A__Base::error_cb>(this);
     }
@@ -285,7 +285,7 @@ bool ConnState_ipv6::setup()
   return true;
 }
 
-void ConnState_ipv6::send_L_Busmonitor (LBusmonPtr l)
+void ConnState_ipv6::send_L_Busmonitor (const L_Busmonitor_PDU &l)
 {
   if (type == CT_BUSMONITOR)
     {
@@ -395,6 +395,9 @@ void ConnState_ipv6::send_trigger_cb(ev::async &w UNUSED, int revents UNUSED)
 
 void ConnState_ipv6::timeout_cb(ev::timer &w UNUSED, int revents UNUSED)
 {
+  auto c = std::dynamic_pointer_cast<LinkConnect>(conn.lock());
+  if (c != nullptr)
+    c->recorder.dump(t, "connection timed out");
   if (channel > 0)
     {
       EIBnet6_DisconnectRequest r;
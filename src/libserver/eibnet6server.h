@@ -64,9 +64,9 @@ public:
   int no;
   bool nat;
 
-  ev::timer timeout; void timeout_cb(ev::timer &w, int revents);
-  ev::timer sendtimeout; void sendtimeout_cb(ev::timer &w, int revents);
-  ev::async send_trigger; void send_trigger_cb(ev::async &w, int revents);
+  ev::timer timeout {loop}; void timeout_cb(ev::timer &w, int revents);
+  ev::timer sendtimeout {loop}; void sendtimeout_cb(ev::timer &w, int revents);
+  ev::async send_trigger {loop}; void send_trigger_cb(ev::async &w, int revents);
   bool do_send_next = false;
   Queue < CArray > out;
   void reset_timer();
@@ -81,7 +81,7 @@ public:
   void config_response (EIBnet6_ConfigACK &r1);
 
   void send_L_Data (LDataPtr l);
-  void send_L_Busmonitor (LBusmonPtr l);
+  void send_L_Busmonitor (const L_Busmonitor_PDU &l);
 };
 typedef std::shared_ptr<ConnState_ipv6> ConnState_ipv6Ptr;
 
@@ -155,7 +155,7 @@ public:
   void handle_packet (EIBNet6IPPacket *p1, EIBNet6IPSocket *isock);
 
   void drop_connection (ConnState_ipv6Ptr s);
-  ev::async drop_trigger; void drop_trigger_cb(ev::async &w, int revents);
+  ev::async drop_trigger {loop}; void drop_trigger_cb(ev::async &w, int revents);
 
   inline void Send (EIBNet6IPPacket p) {
     Send (p, mcast->maddr);
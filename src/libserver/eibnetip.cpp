@@ -34,7 +34,7 @@ EIBNetIPPacket::EIBNetIPPacket ()
 }
 
 EIBNetIPPacket *
-EIBNetIPPacket::fromPacket (const CArray & c, const struct sockaddr_in src)
+EIBNetIPPacket::fromPacket (CArrayView c, const struct sockaddr_in src)
 {
   EIBNetIPPacket *p;
   if (c.size() < 6)
@@ -96,12 +96,12 @@ IPtoEIBNetIP (const struct sockaddr_in * a, bool nat)
 }
 
 bool
-EIBnettoIP (const CArray & buf, struct sockaddr_in *a,
+EIBnettoIP (CArrayView buf, struct sockaddr_in *a,
 	    const struct sockaddr_in *src, bool & nat)
 {
   int ip, port;
   memset (a, 0, sizeof (*a));
-  if (buf[0] != 0x8 || buf[1] != 0x1)
+  if (buf.size() < 8 || buf[0] != 0x8 || buf[1] != 0x1)
     return true;
   ip = (buf[2] << 24) | (buf[3] << 16) | (buf[4] << 8) | (buf[5]);
   port = (buf[6] << 8) | (buf[7]);
@@ -200,6 +200,7 @@ EIBNetIPSocket::~EIBNetIPSocket ()
 void
 EIBNetIPSocket::stop()
 {
+  stop_thread();
   if (fd != -1)
     {
       io_recv.stop();
@@ -218,7 +219,13 @@ EIBNetIPSocket::pause()
     if (paused)
         return;
     paused = true;
-    io_recv.stop();
+    if (thread_loop)
+      {
+        thread_paused = true;
+        send_wakeup.send();
+      }
+    else
+      io_recv.stop();
 }
 
 void
@@ -227,7 +234,13 @@ EIBNetIPSocket::unpause()
     if (! paused)
         return;
     paused = false;
-    io_recv.start(fd, ev::READ);
+    if (thread_loop)
+      {
+        thread_paused = false;
+        send_wakeup.send();
+      }
+    else
+      io_recv.start(fd, ev::READ);
 }
 
 bool
@@ -275,6 +288,25 @@ EIBNetIPSocket::Send (EIBNetIPPacket p, struct sockaddr_in addr)
   s.data = p;
   s.addr = addr;
 
+  if (thread_loop)
+    {
+      if (thread_send_q->push (std::move(s)))
+        {
+          send_wakeup.send();
+          /* report the loss once there is room again */
+          if (send_dropped)
+            {
+              ERRORPRINTF (t, E_WARNING | 66, "I/O thread: %lu packets dropped, send queue full", send_dropped);
+              send_dropped = 0;
+            }
+        }
+      else
+        {
+          t->TracePacket (0, "Send queue full, dropped", p.data);
+          send_dropped++;
+        }
+      return;
+    }
   if (send_q.isempty())
     io_send.start(fd, ev::WRITE);
   send_q.put (std::move(s));
@@ -286,7 +318,13 @@ EIBNetIPSocket::io_send_cb (ev::io &w UNUSED, int revents UNUSED)
   if (send_q.isempty ())
     {
       io_send.stop();
-      on_next();
+      if (thread_loop)
+        {
+          thread_next = true;
+          recv_wakeup.send();
+        }
+      else
+        on_next();
       return;
     }
   const struct _EIBNetIP_Send s = send_q.front ();
@@ -309,7 +347,13 @@ EIBNetIPSocket::io_send_cb (ev::io &w UNUSED, int revents UNUSED)
               t->TracePacket (0, "EIBnetSocket:drop", p);
               send_q.get ();
               send_error = 0;
-              on_error();
+              if (thread_loop)
+                {
+                  thread_error = true;
+                  recv_wakeup.send();
+                }
+              else
+                on_error();
             }
         }
     }
@@ -326,7 +370,16 @@ EIBNetIPSocket::io_recv_cb (ev::io &w UNUSED, int revents UNUSED)
 
   int i = recvfrom (fd, buf, sizeof (buf), 0, (struct sockaddr *) &r, &rl);
   if (i < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
-    on_error();
+    {
+      if (thread_loop)
+        {
+          io_recv.stop();
+          thread_error = true;
+          recv_wakeup.send();
+        }
+      else
+        on_error();
+    }
   else if (i >= 0 && rl == sizeof (r))
     {
       if (recvall == 1 || !memcmp (&r, &recvaddr, sizeof (r)) ||
@@ -335,9 +388,9 @@ EIBNetIPSocket::io_recv_cb (ev::io &w UNUSED, int revents UNUSED)
         {
           t->TracePacket (0, "Recv", i, buf);
           EIBNetIPPacket *p =
-            EIBNetIPPacket::fromPacket (CArray (buf, i), r);
+            EIBNetIPPacket::fromPacket (CArrayView (buf, i), r);
           if (p)
-            on_recv(p);
+            deliver(p);
           else
             t->TracePacket (0, "Parse?", i, buf);
         }
@@ -346,6 +399,143 @@ EIBNetIPSocket::io_recv_cb (ev::io &w UNUSED, int revents UNUSED)
     }
 }
 
+void
+EIBNetIPSocket::deliver (EIBNetIPPacket *p)
+{
+  if (!thread_loop)
+    {
+      on_recv(p);
+      return;
+    }
+  if (thread_recv_q->push (std::move(p)))
+    recv_wakeup.send();
+  else
+    {
+      delete p;
+      thread_dropped++;
+    }
+}
+
+bool
+EIBNetIPSocket::start_thread (unsigned int queue_len)
+{
+  if (fd < 0 || thread_loop)
+    return false;
+  thread_loop = ev_loop_new (EVFLAG_AUTO);
+  if (!thread_loop)
+    return false;
+
+  thread_recv_q.reset (new SPSCQueue<EIBNetIPPacket *>(queue_len));
+  thread_send_q.reset (new SPSCQueue<struct _EIBNetIP_Send>(queue_len));
+  thread_paused = paused;
+  thread_stop = false;
+
+  /* move the watchers over; the thread isn't running yet */
+  bool reading = io_recv.is_active();
+  bool writing = io_send.is_active();
+  thread_read = reading || paused;
+  io_recv.stop();
+  io_send.stop();
+  io_recv.set(thread_loop);
+  io_send.set(thread_loop);
+  if (reading)
+    io_recv.start(fd, ev::READ);
+  if (writing)
+    io_send.start(fd, ev::WRITE);
+
+  send_wakeup.set(thread_loop);
+  send_wakeup.set<EIBNetIPSocket, &EIBNetIPSocket::send_wakeup_cb>(this);
+  send_wakeup.start();
+  recv_wakeup.set<EIBNetIPSocket, &EIBNetIPSocket::recv_wakeup_cb>(this);
+  recv_wakeup.start();
+
+  io_thread = std::thread (&EIBNetIPSocket::run_thread, this);
+  TRACEPRINTF (t, 0, "I/O thread started");
+  return true;
+}
+
+void
+EIBNetIPSocket::run_thread ()
+{
+  ev_run (thread_loop, 0);
+}
+
+void
+EIBNetIPSocket::stop_thread ()
+{
+  if (!thread_loop)
+    return;
+
+  thread_stop = true;
+  send_wakeup.send();
+  io_thread.join();
+
+  recv_wakeup.stop();
+  io_recv.set(loop);
+  io_send.set(loop);
+  send_wakeup.set(loop);
+  ev_loop_destroy (thread_loop);
+  thread_loop = nullptr;
+
+  EIBNetIPPacket *p;
+  while (thread_recv_q->pop (p))
+    delete p;
+  if (send_dropped)
+    ERRORPRINTF (t, E_WARNING | 66, "I/O thread: %lu packets dropped, send queue full", send_dropped);
+  send_dropped = 0;
+  TRACEPRINTF (t, 0, "I/O thread stopped");
+}
+
+/* runs in the I/O thread */
+void
+EIBNetIPSocket::send_wakeup_cb (ev::async &w UNUSED, int revents UNUSED)
+{
+  if (thread_stop)
+    {
+      io_recv.stop();
+      io_send.stop();
+      send_wakeup.stop();
+      ev_break (thread_loop, EVBREAK_ALL);
+      return;
+    }
+
+  if (thread_paused)
+    io_recv.stop();
+  else if (thread_read && !io_recv.is_active() && !thread_error)
+    io_recv.start(fd, ev::READ);
+
+  struct _EIBNetIP_Send s;
+  bool had = !send_q.isempty();
+  while (thread_send_q->pop (s))
+    send_q.put (std::move(s));
+  if (!had && !send_q.isempty())
+    io_send.start(fd, ev::WRITE);
+}
+
+/** how many packets to pass on per main loop iteration */
+#define RECV_BATCH 16
+
+/* runs in the main loop */
+void
+EIBNetIPSocket::recv_wakeup_cb (ev::async &w UNUSED, int revents UNUSED)
+{
+  EIBNetIPPacket *p;
+  unsigned int n = 0;
+  while (n++ < RECV_BATCH && thread_recv_q->pop (p))
+    on_recv(p);
+  /* let other drivers run before handling the rest */
+  if (!thread_recv_q->empty())
+    recv_wakeup.send();
+
+  unsigned long dropped = thread_dropped.exchange(0);
+  if (dropped)
+    ERRORPRINTF (t, E_WARNING | 66, "I/O thread: %lu packets dropped, receive queue full", dropped);
+  if (thread_next.exchange(false))
+    on_next();
+  if (thread_error.exchange(false))
+    on_error();
+}
+
 bool
 EIBNetIPSocket::SetInterface(std::string& iface)
 {
@@ -392,13 +582,13 @@ parseEIBnet_ConnectRequest (const EIBNetIPPacket & p,
     return 1;
   if (p.data.size() < 18)
     return 1;
-  if (EIBnettoIP (CArray (p.data.data(), 8), &r.caddr, &p.src, r.nat))
+  if (EIBnettoIP (CArrayView (p.data).sub (0, 8), &r.caddr, &p.src, r.nat))
     return 1;
-  if (EIBnettoIP (CArray (p.data.data() + 8, 8), &r.daddr, &p.src, r.nat))
+  if (EIBnettoIP (CArrayView (p.data).sub (8, 8), &r.daddr, &p.src, r.nat))
     return 1;
   if (p.data.size() - 16 != p.data[16])
     return 1;
-  r.CRI = CArray (p.data.data() + 17, p.data.size() - 17);
+  r.CRI.set (p.data.data() + 17, p.data.size() - 17);
   return 0;
 }
 
@@ -448,13 +638,13 @@ parseEIBnet_ConnectResponse (const EIBNetIPPacket & p,
     }
   if (p.data.size() < 12)
     return 1;
-  if (EIBnettoIP (CArray (p.data.data() + 2, 8), &r.daddr, &p.src, r.nat))
+  if (EIBnettoIP (CArrayView (p.data).sub (2, 8), &r.daddr, &p.src, r.nat))
     return 1;
   if (p.data.size() - 10 != p.data[10])
     return 1;
   r.channel = p.data[0];
   r.status = p.data[1];
-  r.CRD = CArray (p.data.data() + 11, p.data.size() - 11);
+  r.CRD.set (p.data.data() + 11, p.data.size() - 11);
   return 0;
 }
 
@@ -485,7 +675,7 @@ parseEIBnet_ConnectionStateRequest (const EIBNetIPPacket & p,
     return 1;
   if (p.data.size() != 10)
     return 1;
-  if (EIBnettoIP (CArray (p.data.data() + 2, 8), &r.caddr, &p.src, r.nat))
+  if (EIBnettoIP (CArrayView (p.data).sub (2, 8), &r.caddr, &p.src, r.nat))
     return 1;
   r.channel = p.data[0];
   return 0;
@@ -547,7 +737,7 @@ parseEIBnet_DisconnectRequest (const EIBNetIPPacket & p,
     return 1;
   if (p.data.size() != 10)
     return 1;
-  if (EIBnettoIP (CArray (p.data.data() + 2, 8), &r.caddr, &p.src, r.nat))
+  if (EIBnettoIP (CArrayView (p.data).sub (2, 8), &r.caddr, &p.src, r.nat))
     return 1;
   r.channel = p.data[0];
   return 0;
@@ -909,7 +1099,7 @@ parseEIBnet_SearchResponse (const EIBNetIPPacket & p,
     return 1;
   if (p.data.size() < 64)
     return 1;
-  if (EIBnettoIP (CArray (p.data.data() + 0, 8), &r.caddr, &p.src, r.nat))
+  if (EIBnettoIP (CArrayView (p.data).sub (0, 8), &r.caddr, &p.src, r.nat))
     return 1;
   if (p.data[8] != 54)
     return 1;
@@ -22,7 +22,10 @@
 
 #include <netinet/in.h>
 #include <ev++.h>
+#include <atomic>
+#include <thread>
 #include "common.h"
+#include "spscqueue.h"
 #include "iobuf.h" // for nonblocking
 #include "lpdu.h"
 #include "ipsupport.h"
@@ -114,7 +117,7 @@ public:
 
   EIBNetIPPacket ();
   /** create from character array */
-  static EIBNetIPPacket *fromPacket (const CArray & c,
+  static EIBNetIPPacket *fromPacket (CArrayView c,
 				     const struct sockaddr_in src);
   /** convert to character array */
   CArray ToPacket () const;
@@ -380,15 +383,25 @@ struct _EIBNetIP_Send
   struct sockaddr_in addr;
 };
 
-/** EIBnet/IP socket */
+/** default length of the queues to and from an I/O thread */
+#define EIBNETIP_THREAD_QUEUE 256
+
+/** EIBnet/IP socket
+ *
+ * Normally this runs on the main loop. After start_thread(), the socket
+ * calls and packet parsing happen in a separate thread with its own event
+ * loop, so that bursts of IP traffic don't delay the serial drivers. The
+ * callbacks still run on the main loop: packets are handed over through
+ * two SPSC queues, with an ev::async wakeup in each direction.
+ */
 class EIBNetIPSocket
 {
   /** debug output */
   TracePtr t;
   /** input */
-  ev::io io_recv; void io_recv_cb (ev::io &w, int revents);
+  ev::io io_recv {loop}; void io_recv_cb (ev::io &w, int revents);
   /** output */
-  ev::io io_send; void io_send_cb (ev::io &w, int revents);
+  ev::io io_send {loop}; void io_send_cb (ev::io &w, int revents);
   unsigned int send_error;
 
 public:
@@ -415,6 +428,31 @@ private:
   /** multicast in use? */
   bool multicast;
 
+  /** I/O thread, if any */
+  struct ev_loop *thread_loop = nullptr;
+  std::thread io_thread;
+  void run_thread ();
+  /** parsed packets, from the thread */
+  std::unique_ptr<SPSCQueue<EIBNetIPPacket *>> thread_recv_q;
+  /** packets to send, to the thread */
+  std::unique_ptr<SPSCQueue<struct _EIBNetIP_Send>> thread_send_q;
+  /** main loop: packets or events from the thread */
+  ev::async recv_wakeup {loop}; void recv_wakeup_cb (ev::async &w, int revents);
+  /** thread loop: packets or commands from the main loop */
+  ev::async send_wakeup {loop}; void send_wakeup_cb (ev::async &w, int revents);
+  /** does the thread read at all (i.e. not S_WR)? */
+  bool thread_read = false;
+  std::atomic<bool> thread_stop {false};
+  std::atomic<bool> thread_paused {false};
+  std::atomic<bool> thread_error {false};
+  std::atomic<bool> thread_next {false};
+  std::atomic<unsigned long> thread_dropped {0};
+  /** packets dropped because thread_send_q was full; main loop only */
+  unsigned long send_dropped = 0;
+  void stop_thread ();
+  /** pass a received packet on */
+  void deliver (EIBNetIPPacket *p);
+
 public:
   EIBNetIPSocket (struct sockaddr_in bindaddr, bool reuseaddr, TracePtr tr,
                   SockMode mode = S_RDWR);
@@ -422,6 +460,11 @@ public:
   bool init ();
   void stop();
 
+  /** Move I/O to a separate thread. Call this after the socket is fully
+   * set up: the receive filter (recvall, recvaddr …) must not be changed
+   * afterwards. */
+  bool start_thread (unsigned int queue_len = EIBNETIP_THREAD_QUEUE);
+
   /** enables multicast */
   bool SetMulticast (struct ip_mreq multicastaddr);
   /** sends a packet */
@@ -390,9 +390,9 @@ class EIBNet6IPSocket
   /** debug output */
   TracePtr t;
   /** input */
-  ev::io io_recv; void io_recv_cb (ev::io &w, int revents);
+  ev::io io_recv {loop}; void io_recv_cb (ev::io &w, int revents);
   /** output */
-  ev::io io_send; void io_send_cb (ev::io &w, int revents);
+  ev::io io_send {loop}; void io_send_cb (ev::io &w, int revents);
   unsigned int send_error;
 
 public:
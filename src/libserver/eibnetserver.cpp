@@ -123,6 +123,15 @@ EIBnetDriver::setup()
   return true;
 }
 
+bool
+EIBnetDriver::start_thread()
+{
+  EIBnetServer &parent = *std::static_pointer_cast<EIBnetServer>(server);
+  if (sock == parent.sock)
+    return true;
+  return sock->start_thread ();
+}
+
 EIBnetServer::~EIBnetServer ()
 {
   stop_();
@@ -150,6 +159,7 @@ EIBnetServer::setup()
   tunnel = tunnel_cfg->name.size() > 0;
   discover = cfg->value("discover",false);
   single_port = !cfg->value("multi-port",false);
+  io_thread = cfg->value("io-thread",false);
   multicastaddr = cfg->value("multicast-address","224.0.23.12");
   port = cfg->value("port",3671);
   interface = cfg->value("interface","");
@@ -223,6 +233,14 @@ EIBnetServer::start()
   mcast_conn->set_driver(mcast);
   if (!mcast_conn->setup ())
     goto err_out3;
+  if (io_thread)
+    {
+      if (!sock->start_thread ())
+        goto err_out3;
+      if (!mcast->start_thread ())
+        goto err_out3;
+    }
+
   if (route && !static_cast<Router &>(router).registerLink(mcast_conn))
     goto err_out3;
 
@@ -278,7 +296,7 @@ bool ConnState::setup()
   return true;
 }
 
-void ConnState::send_L_Busmonitor (LBusmonPtr l)
+void ConnState::send_L_Busmonitor (const L_Busmonitor_PDU &l)
 {
   if (type == CT_BUSMONITOR)
     {
@@ -388,6 +406,9 @@ void ConnState::send_trigger_cb(ev::async &w UNUSED, int revents UNUSED)
 
 void ConnState::timeout_cb(ev::timer &w UNUSED, int revents UNUSED)
 {
+  auto c = std::dynamic_pointer_cast<LinkConnect>(conn.lock());
+  if (c != nullptr)
+    c->recorder.dump(t, "connection timed out");
   if (channel > 0)
     {
       EIBnet_DisconnectRequest r;
@@ -60,9 +60,9 @@ public:
   int no;
   bool nat;
 
-  ev::timer timeout; void timeout_cb(ev::timer &w, int revents);
-  ev::timer sendtimeout; void sendtimeout_cb(ev::timer &w, int revents);
-  ev::async send_trigger; void send_trigger_cb(ev::async &w, int revents);
+  ev::timer timeout {loop}; void timeout_cb(ev::timer &w, int revents);
+  ev::timer sendtimeout {loop}; void sendtimeout_cb(ev::timer &w, int revents);
+  ev::async send_trigger {loop}; void send_trigger_cb(ev::async &w, int revents);
   bool do_send_next = false;
   Queue < CArray > out;
   void reset_timer();
@@ -77,7 +77,7 @@ public:
   void config_response (EIBnet_ConfigACK &r1);
 
   void send_L_Data (LDataPtr l);
-  void send_L_Busmonitor (LBusmonPtr l);
+  void send_L_Busmonitor (const L_Busmonitor_PDU &l);
 };
 typedef std::shared_ptr<ConnState> ConnStatePtr;
 
@@ -97,6 +97,8 @@ public:
   struct sockaddr_in maddr;
 
   bool setup();
+  /** move our own socket, if any, to an I/O thread */
+  bool start_thread();
   // void start();
   // void stop();
 
@@ -123,6 +125,7 @@ SERVER(EIBnetServer,ets_router)
   bool route;
   bool discover;
   bool single_port;
+  bool io_thread;
   std::string multicastaddr;
   uint16_t port;
   std::string interface;
@@ -151,7 +154,7 @@ public:
   void handle_packet (EIBNetIPPacket *p1, EIBNetIPSocket *isock);
 
   void drop_connection (ConnStatePtr s);
-  ev::async drop_trigger; void drop_trigger_cb(ev::async &w, int revents);
+  ev::async drop_trigger {loop}; void drop_trigger_cb(ev::async &w, int revents);
 
   inline void Send (EIBNetIPPacket p) {
     Send (p, mcast->maddr);
@@ -54,7 +54,7 @@ public:
 DRIVER_(USBDriver,LowLevelAdapter,usb)
 {
   // for EMI version discovery
-  ev::timer timeout;
+  ev::timer timeout {loop};
   int cnt = 0;
   void timeout_cb(ev::timer &w, int revents);
   void xmit();
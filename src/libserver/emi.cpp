@@ -64,7 +64,7 @@ L_Data_ToCEMI (uchar code, const LDataPtr & l1)
 }
 
 LDataPtr
-CEMI_to_L_Data (const CArray & data, TracePtr t)
+CEMI_to_L_Data (CArrayView data, TracePtr t)
 {
   if (data.size() < 2)
     {
@@ -117,7 +117,7 @@ CEMI_to_L_Data (const CArray & data, TracePtr t)
 }
 
 LBusmonPtr
-CEMI_to_Busmonitor (const CArray & data, DriverPtr l2 UNUSED)
+CEMI_to_Busmonitor (CArrayView data, DriverPtr l2 UNUSED)
 {
   if (data.size() < 2)
     return nullptr;
@@ -136,10 +136,10 @@ CEMI_to_Busmonitor (const CArray & data, DriverPtr l2 UNUSED)
 #define CEMI_ADD_HEADER_TYPE_EXTTIMESTAMP 0x06
 
 CArray
-Busmonitor_to_CEMI (uchar code, const LBusmonPtr & p, int no)
+Busmonitor_to_CEMI (uchar code, const L_Busmonitor_PDU & p, int no)
 {
   CArray pdu;
-  pdu.resize (p->pdu.size() + 9);
+  pdu.resize (p.pdu.size() + 9);
   pdu[0] = code;
   pdu[1] = 7;        /* AddIL */
   pdu[2] = CEMI_ADD_HEADER_TYPE_STATUS;        /* Type ID = L_Busmon.ind */
@@ -147,10 +147,10 @@ Busmonitor_to_CEMI (uchar code, const LBusmonPtr & p, int no)
   pdu[4] = no & 0x7; /* Status */
   pdu[5] = CEMI_ADD_HEADER_TYPE_TIMESTAMP;
   pdu[6] = 2;        // Length of data for TIMESTAMP
-  pdu[7] = (p->timestamp & 0x0000ff00) >> 8;
-  pdu[8] = (p->timestamp & 0x000000ff);
+  pdu[7] = (p.timestamp & 0x0000ff00) >> 8;
+  pdu[8] = (p.timestamp & 0x000000ff);
 
-  pdu.setpart (p->pdu, 9);
+  pdu.setpart (p.pdu, 9);
   return pdu;
 }
 
@@ -190,14 +190,15 @@ L_Data_ToEMI (uchar code, const LDataPtr & l1)
 }
 
 LDataPtr
-EMI_to_L_Data (const CArray & data, TracePtr t UNUSED)
+EMI_to_L_Data (CArrayView data, TracePtr t UNUSED)
 {
-  LDataPtr c = LDataPtr(new L_Data_PDU ());
   unsigned len;
 
   if (data.size() < 8)
     return 0;
 
+  LDataPtr c = LDataPtr(new L_Data_PDU ());
+
   c->source = (data[2] << 8) | (data[3]);
   c->dest = (data[4] << 8) | (data[5]);
   switch ((data[1] >> 2) & 0x3)
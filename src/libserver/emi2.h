@@ -26,7 +26,7 @@
 class EMI2Driver:public EMI_Common
 {
   bool reset_ack_wait = false;
-  ev::timer reset_timer;
+  ev::timer reset_timer {loop};
 
   void cmdEnterMonitor();
   void cmdLeaveMonitor();
@@ -77,7 +77,7 @@ protected:
 private:
   bool monitor = false;
 
-  ev::timer timeout;
+  ev::timer timeout {loop};
   void timeout_cb(ev::timer &w, int revents);
   CArray out; // caches the packet to send
   int retries;
@@ -97,7 +97,7 @@ public:
 
   virtual CArray lData2EMI (uchar code, const LDataPtr &p)
   { return L_Data_ToEMI(code, p); }
-  virtual LDataPtr EMI2lData (const CArray & data)
+  virtual LDataPtr EMI2lData (CArrayView data)
   { return EMI_to_L_Data(data, t); }
 
   virtual unsigned int maxPacketLen() { return 0x10; }
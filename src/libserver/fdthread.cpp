@@ -0,0 +1,247 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <poll.h>
+
+#include "fdthread.h"
+#include "iobuf.h"
+
+FDThread::FDThread (TracePtr tr)
+{
+  t = tr;
+  on_read.set<FDThread,&FDThread::read_cb>(this); // dummy
+  on_error.set<FDThread,&FDThread::error_cb>(this); // dummy
+  wakeup.set<FDThread,&FDThread::wakeup_cb>(this);
+}
+
+FDThread::~FDThread ()
+{
+  stop();
+}
+
+bool
+FDThread::setup (IniSectionPtr &cfg)
+{
+  queue_len = cfg->value("buffer-thread-queue",FDTHREAD_QUEUE);
+  if (queue_len < 2)
+    queue_len = 2;
+  return true;
+}
+
+bool
+FDThread::start (int fd)
+{
+  int p[2];
+
+  assert (fd >= 0);
+  assert (this->fd == -1);
+  if (pipe (p) < 0)
+    {
+      ERRORPRINTF (t, E_ERROR | 68, "I/O thread: pipe: %s", strerror(errno));
+      return false;
+    }
+  wake_r = p[0];
+  wake_w = p[1];
+  set_non_blocking (wake_r);
+  set_non_blocking (wake_w);
+  set_non_blocking (fd);
+
+  this->fd = fd;
+  recv_q.reset (new SPSCQueue<CArray *>(queue_len));
+  send_q.reset (new SPSCQueue<CArray *>(queue_len));
+  stopping = false;
+  error = 0;
+  throttled = false;
+
+  wakeup.start();
+  thread = std::thread (&FDThread::run, this);
+  TRACEPRINTF (t, 2, "I/O thread started on fd %d", fd);
+  return true;
+}
+
+void
+FDThread::stop ()
+{
+  if (fd == -1)
+    return;
+
+  stopping = true;
+  wake();
+  thread.join();
+  wakeup.stop();
+  close (wake_r);
+  close (wake_w);
+  wake_r = wake_w = -1;
+  fd = -1;
+
+  CArray *c;
+  while (recv_q->pop (c))
+    delete c;
+  while (send_q->pop (c))
+    delete c;
+  TRACEPRINTF (t, 2, "I/O thread stopped");
+}
+
+void
+FDThread::write (CArray *data)
+{
+  if (fd == -1 || !send_q->push (std::move(data)))
+    {
+      ERRORPRINTF (t, E_WARNING | 68, "I/O thread: send queue full, %d bytes dropped", data->size());
+      delete data;
+      return;
+    }
+  wake();
+}
+
+void
+FDThread::wake ()
+{
+  char c = 0;
+  if (::write (wake_w, &c, 1) < 0 && errno != EAGAIN)
+    ERRORPRINTF (t, E_WARNING | 68, "I/O thread: wakeup: %s", strerror(errno));
+}
+
+/* runs in the I/O thread */
+void
+FDThread::run ()
+{
+  Queue<CArray *> out;
+  size_t outpos = 0;
+  uint8_t buf[256];
+  int err = 0;
+
+  while (!stopping)
+    {
+      struct pollfd pfd[2];
+      pfd[0].fd = fd;
+      /* Don't read while the main loop is behind: dropping data would
+       * desync the driver's parser, so leave it in the kernel's buffer.
+       * wakeup_cb() wakes us up when there's room again. */
+      bool full = false;
+      if (recv_q->full())
+        {
+          throttled = true;
+          /* pairs with the fence in wakeup_cb(): either we see the
+           * room it made, or it sees our flag */
+          std::atomic_thread_fence (std::memory_order_seq_cst);
+          full = recv_q->full();
+        }
+      pfd[0].events = (full ? 0 : POLLIN) | (out.isempty() ? 0 : POLLOUT);
+      pfd[1].fd = wake_r;
+      pfd[1].events = POLLIN;
+
+      if (poll (pfd, 2, -1) < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          err = errno;
+          break;
+        }
+
+      if (pfd[1].revents & POLLIN)
+        {
+          while (read (wake_r, buf, sizeof (buf)) > 0)
+            ;
+          CArray *c;
+          while (send_q->pop (c))
+            out.put (std::move(c));
+        }
+
+      if (pfd[0].revents & POLLIN)
+        {
+          ssize_t len = read (fd, buf, sizeof (buf));
+          if (len > 0)
+            {
+              /* can't fail, we checked that there's room */
+              recv_q->push (new CArray (buf, len));
+              wakeup.send();
+            }
+          else if (len == 0)
+            {
+              err = EPIPE;
+              break;
+            }
+          else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+              err = errno;
+              break;
+            }
+        }
+      else if (pfd[0].revents & (POLLERR | POLLHUP | POLLNVAL))
+        {
+          err = EIO;
+          break;
+        }
+
+      /* don't wait for POLLOUT, the device is usually ready */
+      while (!out.isempty())
+        {
+          CArray *c = out.front();
+          ssize_t len = ::write (fd, c->data() + outpos, c->size() - outpos);
+          if (len < 0)
+            {
+              if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                err = errno;
+              break;
+            }
+          outpos += len;
+          if (outpos < c->size())
+            continue;
+          outpos = 0;
+          delete out.get();
+        }
+      if (err)
+        break;
+    }
+
+  while (!out.isempty())
+    delete out.get();
+  if (err && !stopping)
+    {
+      error = err;
+      wakeup.send();
+    }
+}
+
+/* runs in the main loop */
+void
+FDThread::wakeup_cb (ev::async &w UNUSED, int revents UNUSED)
+{
+  CArray *c;
+  while (recv_q->pop (c))
+    {
+      on_read(c->data(), c->size());
+      delete c;
+    }
+
+  std::atomic_thread_fence (std::memory_order_seq_cst);
+  if (throttled.exchange (false))
+    wake();
+
+  int err = error.exchange (0);
+  if (err)
+    {
+      errno = err;
+      on_error();
+    }
+}
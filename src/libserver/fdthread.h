@@ -0,0 +1,95 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef EIB_FDTHREAD_H
+#define EIB_FDTHREAD_H
+
+#include <atomic>
+#include <thread>
+#include <ev++.h>
+
+#include "common.h"
+#include "callbacks.h"
+#include "inifile.h"
+#include "spscqueue.h"
+
+/** default length of the queues to and from the I/O thread */
+#define FDTHREAD_QUEUE 64
+
+/** Serial I/O in a separate thread
+ *
+ * This replaces SendBuf+RecvBuf for a driver whose timing should not
+ * depend on how busy the main loop is. The thread only reads and writes
+ * the file descriptor; received data is handed to the main loop through
+ * a lock-free queue, and data to send comes back the same way.
+ *
+ * Frame assembly, timeouts and the decision whether to acknowledge a
+ * frame stay with the driver on the main loop, so this does not make
+ * the ACK timing deterministic. It only keeps a busy main loop from
+ * delaying the actual reads and writes.
+ */
+class FDThread
+{
+public:
+  /** data has been read; called on the main loop.
+   * Unlike RecvBuf, the callback must consume all of it. */
+  DataCallback on_read;
+  /** read or write failed; errno is set. Called on the main loop. */
+  InfoCallback on_error;
+
+  // dummy methods, to be overridden
+  size_t read_cb(uint8_t *buf UNUSED, size_t len) { return len; }
+  void error_cb() {}
+
+  FDThread (TracePtr tr);
+  ~FDThread ();
+
+  /** read the buffer-thread-* options */
+  bool setup (IniSectionPtr &cfg);
+  /** start working on this file descriptor */
+  bool start (int fd);
+  /** stop the thread and discard anything that's still queued */
+  void stop ();
+  /** queue data for sending. Takes ownership. */
+  void write (CArray *data);
+
+private:
+  TracePtr t;
+  int fd = -1;
+
+  unsigned int queue_len;
+
+  std::thread thread;
+  void run ();
+  /** wakes up the thread: write one byte to wake_w */
+  int wake_r = -1, wake_w = -1;
+  void wake ();
+
+  std::unique_ptr<SPSCQueue<CArray *>> recv_q;
+  std::unique_ptr<SPSCQueue<CArray *>> send_q;
+
+  /** main loop: data or an error from the thread */
+  ev::async wakeup {loop}; void wakeup_cb (ev::async &w, int revents);
+  std::atomic<bool> stopping {false};
+  std::atomic<int> error {0};
+  /** the thread stopped reading because recv_q is full */
+  std::atomic<bool> throttled {false};
+};
+
+#endif
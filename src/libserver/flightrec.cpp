@@ -0,0 +1,99 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "flightrec.h"
+#include "lpdu.h"
+
+#define FR_GROUP 0x01
+#define FR_BUSY 0x02
+#define FR_REPEATED 0x04
+
+void
+FlightRecorder::setup (unsigned int n)
+{
+  size = n;
+  count = 0;
+  ring = std::unique_ptr<Entry[]>(n ? new Entry[n] : nullptr);
+}
+
+void
+FlightRecorder::add (Dir dir, const L_Data_PDU &l, unsigned int queued, bool busy)
+{
+  if (!size)
+    return;
+  Entry &e = next();
+  e.time = ev_now (loop);
+  e.dir = dir;
+  e.flags = (l.AddrType == GroupAddress ? FR_GROUP : 0)
+            | (busy ? FR_BUSY : 0) | (l.repeated ? FR_REPEATED : 0);
+  e.queued = queued > 0xFFFF ? 0xFFFF : queued;
+  e.source = l.source;
+  e.dest = l.dest;
+  e.len = l.data.size() > 0xFF ? 0xFF : l.data.size();
+  memcpy (e.data, l.data.data(), e.len < max_data ? e.len : max_data);
+}
+
+void
+FlightRecorder::add (const L_Busmonitor_PDU &l, unsigned int queued)
+{
+  if (!size)
+    return;
+  Entry &e = next();
+  e.time = ev_now (loop);
+  e.dir = FR_MON;
+  e.flags = l.status;
+  e.queued = queued > 0xFFFF ? 0xFFFF : queued;
+  e.source = 0;
+  e.dest = 0;
+  e.len = l.pdu.size() > 0xFF ? 0xFF : l.pdu.size();
+  memcpy (e.data, l.pdu.data(), e.len < max_data ? e.len : max_data);
+}
+
+void
+FlightRecorder::dump (TracePtr t, const char *reason)
+{
+  if (!size)
+    return;
+
+  ev_tstamp now = ev_now (loop);
+  unsigned long n = count < size ? count : size;
+  t->TracePrintf (0, "Last %lu frames (%s):", n, reason);
+
+  for (unsigned long i = count - n; i < count; i++)
+    {
+      const Entry &e = ring[i % size];
+      String s;
+      for (unsigned int j = 0; j < e.len && j < max_data; j++)
+        addHex (s, e.data[j]);
+      if (e.len > max_data)
+        s += "...";
+
+      if (e.dir == FR_MON)
+        t->TracePrintf (0, "%8.3f mon  status %02x q=%d: %s",
+                        e.time - now, e.flags, e.queued, s);
+      else
+        t->TracePrintf (0, "%8.3f %s %s > %s q=%d%s%s: %s",
+                        e.time - now, e.dir == FR_IN ? "in " : "out",
+                        FormatEIBAddr (e.source),
+                        e.flags & FR_GROUP ? FormatGroupAddr (e.dest)
+                                           : FormatEIBAddr (e.dest),
+                        e.queued, e.flags & FR_BUSY ? " busy" : "",
+                        e.flags & FR_REPEATED ? " rep" : "", s);
+    }
+}
@@ -0,0 +1,83 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef EIB_FLIGHTREC_H
+#define EIB_FLIGHTREC_H
+
+#include <memory>
+#include <ev++.h>
+
+#include "types.h"
+#include "trace.h"
+
+class L_Data_PDU;
+class L_Busmonitor_PDU;
+
+/** The last couple of frames a link has seen.
+ *
+ * This is always on, so that when a link fails we can show what led up to
+ * it without having had to enable tracing beforehand. Recording a frame
+ * copies its addresses and the start of its payload into a fixed-size
+ * ring; nothing is formatted until dump() is called.
+ */
+class FlightRecorder
+{
+public:
+  enum Dir : uint8_t { FR_IN, FR_OUT, FR_MON };
+
+  /** Allocate room for n frames; 0 turns recording off. */
+  void setup (unsigned int n);
+
+  /** record a frame
+   * @param queued frames waiting in the router
+   * @param busy the driver hasn't accepted the previous frame yet */
+  void add (Dir dir, const L_Data_PDU &l, unsigned int queued, bool busy);
+  void add (const L_Busmonitor_PDU &l, unsigned int queued);
+
+  /** print the recorded frames, oldest first */
+  void dump (TracePtr t, const char *reason);
+
+private:
+  /** payload bytes kept per frame */
+  static const unsigned int max_data = 16;
+
+  struct Entry
+  {
+    ev_tstamp time;
+    Dir dir;
+    uint8_t flags;
+    uint16_t queued;
+    eibaddr_t source;
+    eibaddr_t dest;
+    uint8_t len;
+    uint8_t data[max_data];
+  };
+
+  std::unique_ptr<Entry[]> ring;
+  unsigned int size = 0;
+  /** total number of frames recorded */
+  unsigned long count = 0;
+
+  Entry& next ()
+    {
+      return ring[count++ % size];
+    }
+};
+
+#endif
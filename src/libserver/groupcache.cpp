@@ -17,10 +17,15 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 */
 
+#include <algorithm>
+
 #include "groupcache.h"
 #include "tpdu.h"
 #include "apdu.h"
 
+/** upper bound for the history setting, so that a history fits into one message */
+#define MAX_HISTORY 200
+
 GroupCache::GroupCache (const LinkConnectPtr& c, IniSectionPtr& s)
 	: Driver(c,s)
 {
@@ -51,9 +56,95 @@ GroupCache::setup()
     return false;
   remtrigger.start();
   this->maxsize = cfg->value("max-size", 0xFFFF);
+
+  int hs = cfg->value("history", 0);
+  if (hs < 0 || hs > MAX_HISTORY)
+    {
+      ERRORPRINTF (t, E_ERROR | 55, "history must be between 0 and %d", MAX_HISTORY);
+      return false;
+    }
+  histsize = hs;
+  std::string ha = cfg->value("history-addrs", "");
+  if (ha.size() && !readranges (ha, histaddrs))
+    return false;
+
+  std::string ev = cfg->value("eviction", "oldest");
+  if (ev == "oldest")
+    eviction = GC_EVICT_OLDEST;
+  else if (ev == "clock")
+    eviction = GC_EVICT_CLOCK;
+  else
+    {
+      ERRORPRINTF (t, E_ERROR | 55, "eviction must be 'oldest' or 'clock', not '%s'", ev);
+      return false;
+    }
+  std::string pa = cfg->value("pin-addrs", "");
+  if (pa.size() && !readranges (pa, pinaddrs))
+    return false;
   return true;
 }
 
+/** parses a group address in 3-level or 2-level notation */
+static bool
+readgaddr (const std::string& addr, eibaddr_t& parsed)
+{
+  unsigned int a, b, c;
+  char x;
+  if (sscanf (addr.c_str(), "%u/%u/%u%c", &a, &b, &c, &x) == 3)
+    {
+      if (a > 0x1F || b > 0x07 || c > 0xFF)
+        return false;
+      parsed = (a << 11) | (b << 8) | c;
+      return true;
+    }
+  if (sscanf (addr.c_str(), "%u/%u%c", &a, &b, &x) == 2)
+    {
+      if (a > 0x1F || b > 0x7FF)
+        return false;
+      parsed = (a << 11) | b;
+      return true;
+    }
+  return false;
+}
+
+bool
+GroupCache::readranges (const std::string& s, GroupAddrRanges& r)
+{
+  size_t pos = 0;
+  while (pos <= s.size())
+    {
+      size_t comma = s.find(',', pos);
+      if (comma == std::string::npos)
+        comma = s.size();
+      std::string item = s.substr(pos, comma-pos);
+      size_t dash = item.find('-');
+      GroupAddrRange range;
+
+      if (!readgaddr (item.substr(0, dash), range.lo))
+        goto err;
+      if (dash == std::string::npos)
+        range.hi = range.lo;
+      else if (!readgaddr (item.substr(dash+1), range.hi) || range.hi < range.lo)
+        goto err;
+      r.push_back (range);
+      pos = comma+1;
+      continue;
+    err:
+      ERRORPRINTF (t, E_ERROR | 55, "'%s' is not a group address or range. Use A/B/C or A/B/C-D/E/F.", item);
+      return false;
+    }
+  return true;
+}
+
+static bool
+inranges (const GroupAddrRanges& r, eibaddr_t addr)
+{
+  for (unsigned int i = 0; i < r.size(); i++)
+    if (addr >= r[i].lo && addr <= r[i].hi)
+      return true;
+  return false;
+}
+
 void
 GroupCache::start()
 {
@@ -73,37 +164,36 @@ GroupCache::send_L_Data (LDataPtr l)
 {
   if (enable)
     {
-      TPDUPtr t = TPDU::fromPacket (l->data, this->t);
-      if (t->getType () == T_DATA_XXX_REQ)
+      TPDUView t (l->data);
+      if (t.isGroupResponse () || t.isGroupWrite ())
 	{
-	  T_DATA_XXX_REQ_PDU *t1 = (T_DATA_XXX_REQ_PDU *) &*t;
-	  if (t1->data.size() >= 2 && !(t1->data[0] & 0x3) &&
-	      ((t1->data[1] & 0xC0) == 0x40 || (t1->data[1] & 0xC0) == 0x80)) // response or write
-	    {
-              CacheMap::iterator ci = cache.find (l->dest);
-              CacheMap::value_type *c;
-              if (ci == cache.end())
-                {
-                  while (cache_seq.size() >= maxsize) 
-                    {
-                      SeqMap::iterator si = cache_seq.begin();
-                      cache.erase(si->second);
-                      cache_seq.erase(si);
-                    }
-                  c = &(*cache.emplace(l->dest, GroupCacheEntry(l->dest)).first);
-                }
-              else
-                {
-                  c = &(*ci);
-                  cache_seq.erase(c->second.seq);
-                }
-              c->second.src = l->source;
-              c->second.data = t1->data;
-              c->second.recvtime = time (0);
-              c->second.seq = ++seq;
-              cache_seq.emplace(c->second.seq,c->first);
-              updated(c->second);
-	    }
+          CacheMap::iterator ci = cache.find (l->dest);
+          CacheMap::value_type *c;
+          if (ci == cache.end())
+            {
+              bool pinned = inranges(pinaddrs, l->dest);
+              if (!pinned)
+                while (cache.size() - npinned >= maxsize && evict())
+                  ;
+              c = &(*cache.emplace(l->dest, GroupCacheEntry(l->dest)).first);
+              c->second.pinned = pinned;
+              if (pinned)
+                npinned++;
+            }
+          else
+            {
+              c = &(*ci);
+              cache_seq.erase(c->second.seq);
+            }
+          c->second.changed = (ci == cache.end() || c->second.data != l->data);
+          c->second.src = l->source;
+          c->second.data = l->data;
+          c->second.recvtime = time (0);
+          c->second.seq = ++seq;
+          cache_seq.emplace(c->second.seq,c->first);
+          if (histsize && (histaddrs.empty() || inranges(histaddrs, c->first)))
+            addHistory(c->second);
+          updated(c->second);
 	}
     }
   send_Next();
@@ -117,11 +207,69 @@ GroupCache::Start ()
   return true;
 }
 
+/** Walks the entries in the order of their last update, starting at the
+ * clock hand. Pinned entries are skipped; with the CLOCK policy, entries
+ * which have been read since the last pass lose their mark and are skipped
+ * too. Two rounds suffice to find a victim, if there is one.
+ */
+bool
+GroupCache::evict ()
+{
+  SeqMap::iterator si = (eviction == GC_EVICT_CLOCK)
+                        ? cache_seq.lower_bound(hand) : cache_seq.begin();
+  size_t n = 2 * cache_seq.size();
+  while (n--)
+    {
+      if (si == cache_seq.end())
+        si = cache_seq.begin();
+      CacheMap::iterator ci = cache.find(si->second);
+      if (ci != cache.end())
+        {
+          GroupCacheEntry &e = ci->second;
+          if (e.pinned || (eviction == GC_EVICT_CLOCK && e.referenced))
+            {
+              e.referenced = false;
+              si++;
+              continue;
+            }
+          TRACEPRINTF (t, 8, "GroupCache evict %s", FormatGroupAddr (e.dst));
+          evictions++;
+          cache.erase(ci);
+        }
+      history.erase(si->second);
+      hand = si->first + 1;
+      cache_seq.erase(si);
+      return true;
+    }
+  return false;
+}
+
+CacheMap::iterator
+GroupCache::lookup (eibaddr_t addr, uint16_t age, time_t now)
+{
+  CacheMap::iterator c = cache.find (addr);
+  if (c != cache.end() && age && c->second.recvtime + age < now)
+    c = cache.end();
+  if (c == cache.end())
+    {
+      misses++;
+      return c;
+    }
+  hits++;
+  if (eviction == GC_EVICT_CLOCK)
+    c->second.referenced = true;
+  return c;
+}
+
 void
 GroupCache::Clear ()
 {
-  TRACEPRINTF (t, 4, "GroupCacheClear");
+  TRACEPRINTF (t, 4, "GroupCacheClear: %lu hits, %lu misses, %lu evictions",
+               hits, misses, evictions);
   cache.clear();
+  cache_seq.clear();
+  history.clear();
+  npinned = 0;
 }
 
 void
@@ -138,9 +286,50 @@ GroupCache::remove (eibaddr_t ga)
   CacheMap::iterator f = cache.find(ga);
   if (f != cache.end()) 
     {
+      if (f->second.pinned)
+        npinned--;
       cache_seq.erase(f->second.seq);
       cache.erase(f);
     }
+  history.erase(ga);
+}
+
+void
+GroupCache::addHistory (const GroupCacheEntry &e)
+{
+  GroupCacheHistory &h = history[e.dst];
+  if (h.ring.size() < histsize)
+    {
+      if (h.ring.empty())
+        h.ring.reserve(histsize);
+      h.ring.push_back(e);
+      return;
+    }
+  h.ring[h.pos] = e;
+  if (++h.pos == h.ring.size())
+    h.pos = 0;
+}
+
+void
+GroupCache::History (eibaddr_t addr, uint32_t start, time_t since,
+  GCMultiCallback cb, ClientConnPtr cc)
+{
+  Array<GroupCacheEntry> res;
+
+  TRACEPRINTF (t, 4, "GroupCacheHistory %s %d %d",
+               FormatGroupAddr (addr), start, since);
+  HistoryMap::iterator h = history.find (addr);
+  if (enable && h != history.end())
+    {
+      const Array<GroupCacheEntry> &ring = h->second.ring;
+      for (size_t i = 0; i < ring.size(); i++)
+        {
+          const GroupCacheEntry &e = ring[(h->second.pos + i) % ring.size()];
+          if (e.seq >= start && e.recvtime >= since)
+            res.push_back (e);
+        }
+    }
+  cb(res, cc);
 }
 
 GroupCacheReader::GroupCacheReader(GroupCache *gc)
@@ -204,7 +393,7 @@ class GCReader : protected GroupCacheReader
   ClientConnPtr cc;
   eibaddr_t addr;
   uint16_t age;
-  ev::timer timeout;
+  ev::timer timeout {loop};
 public:
   GCReader(GroupCache *gc, eibaddr_t addr, int Timeout, uint16_t age,
            GCReadCallback cb, ClientConnPtr cc) : GroupCacheReader(gc)
@@ -265,9 +454,7 @@ GroupCache::Read (eibaddr_t addr, unsigned Timeout, uint16_t age,
       return;
     }
 
-  CacheMap::iterator c = cache.find (addr);
-  if (c != cache.end() && age && c->second.recvtime + age < time (0))
-    c = cache.end();
+  CacheMap::iterator c = lookup (addr, age, time (0));
   if (c != cache.end())
     {
       TRACEPRINTF (t, 4, "GroupCache found: %s",
@@ -285,12 +472,17 @@ GroupCache::Read (eibaddr_t addr, unsigned Timeout, uint16_t age,
     }
 
   // No data fond. Send a Read request.
+  new GCReader(this,addr,Timeout,age, cb,cc);
+  sendRead (addr);
+}
+
+void
+GroupCache::sendRead (eibaddr_t addr)
+{
   A_GroupValue_Read_PDU apdu;
   T_DATA_XXX_REQ_PDU tpdu;
   LDataPtr l;
 
-  new GCReader(this,addr,Timeout,age, cb,cc);
-
   tpdu.data = apdu.ToPacket ();
   l = LDataPtr(new L_Data_PDU ());
   l->data = tpdu.ToPacket ();
@@ -300,11 +492,156 @@ GroupCache::Read (eibaddr_t addr, unsigned Timeout, uint16_t age,
   recv_L_Data (std::move(l));
 }
 
+class GCMultiReader : protected GroupCacheReader
+{
+  GCMultiCallback cb;
+  ClientConnPtr cc;
+  Array<GroupCacheEntry> res;
+  /** group address => index into res, for entries still missing */
+  std::unordered_multimap<eibaddr_t, size_t> missing;
+  ev::timer timeout {loop};
+public:
+  GCMultiReader(GroupCache *gc, Array<GroupCacheEntry> &res, int Timeout,
+                GCMultiCallback cb, ClientConnPtr cc) : GroupCacheReader(gc)
+  {
+    this->cb = cb;
+    this->cc = cc;
+    this->res.swap(res);
+    for (size_t i = 0; i < this->res.size(); i++)
+      if (!this->res[i].src)
+        missing.emplace(this->res[i].dst, i);
+    timeout.set<GCMultiReader,&GCMultiReader::timeout_cb>(this);
+    timeout.start(Timeout,0);
+  }
+  virtual ~GCMultiReader()
+    {
+      timeout.stop();
+    }
+private:
+  void updated(GroupCacheEntry &c)
+  {
+    if (stopped)
+      return;
+    auto range = missing.equal_range(c.dst);
+    if (range.first == range.second)
+      return;
+    for (auto i = range.first; i != range.second; i++)
+      res[i->second] = c;
+    missing.erase(range.first, range.second);
+    if (!missing.empty())
+      return;
+
+    TRACEPRINTF (gc->t, 4, "GroupCache multi read complete");
+    timeout.stop();
+    cb(res,cc);
+    stop();
+  }
+
+  void timeout_cb(ev::timer &w UNUSED, int revents UNUSED)
+  {
+    if (stopped)
+      return;
+
+    TRACEPRINTF (gc->t, 4, "GroupCache multi reread timeout, %d missing",
+                 missing.size());
+    cb(res,cc);
+    stop();
+  }
+};
+
+void
+GroupCache::Dump (eibaddr_t start, eibaddr_t end,
+  GCMultiCallback cb, ClientConnPtr cc)
+{
+  Array<GroupCacheEntry> res;
+
+  TRACEPRINTF (t, 4, "GroupCacheDump %s %s",
+               FormatGroupAddr (start), FormatGroupAddr (end));
+  ITER(i, cache)
+    if (i->first >= start && i->first <= end)
+      res.push_back (i->second);
+  std::sort (res.begin(), res.end(),
+             [](const GroupCacheEntry &a, const GroupCacheEntry &b)
+               { return a.dst < b.dst; });
+  cb(res, cc);
+}
+
+void
+GroupCache::ReadMulti (const Array<eibaddr_t> &addrs, unsigned Timeout,
+  uint16_t age, GCMultiCallback cb, ClientConnPtr cc)
+{
+  Array<GroupCacheEntry> res;
+  Array<eibaddr_t> reread;
+  time_t now = time (0);
+
+  TRACEPRINTF (t, 4, "GroupCacheReadMulti %d %d %d",
+               addrs.size(), Timeout, age);
+  res.reserve (addrs.size());
+  for (unsigned int i = 0; i < addrs.size(); i++)
+    {
+      CacheMap::iterator c = enable ? lookup (addrs[i], age, now) : cache.end();
+      if (c != cache.end())
+        res.push_back (c->second);
+      else
+        {
+          res.push_back (GroupCacheEntry (addrs[i]));
+          reread.push_back (addrs[i]);
+        }
+    }
+
+  if (!enable || !Timeout || reread.empty())
+    {
+      cb(res, cc);
+      return;
+    }
+
+  // Some data not found. Send Read requests.
+  new GCMultiReader(this, res, Timeout, cb, cc);
+  std::sort (reread.begin(), reread.end());
+  reread.erase (std::unique (reread.begin(), reread.end()), reread.end());
+  ITER(i, reread)
+    sendRead (*i);
+}
+
+class GCSubscriber : protected GroupCacheReader
+{
+  GCSubscriptionPtr s;
+public:
+  GCSubscriber(GroupCache *gc, GCSubscriptionPtr s) : GroupCacheReader(gc)
+  {
+    this->s = s;
+  }
+private:
+  void updated(GroupCacheEntry &c)
+  {
+    if (stopped)
+      return;
+    if (s->cc == nullptr)
+      {
+        stop();
+        return;
+      }
+    if (s->changes_only && !c.changed)
+      return;
+    if (!s->addrs.empty() && !inranges(s->addrs, c.dst))
+      return;
+    s->cb(c, false, s->cc);
+  }
+};
+
+void
+GroupCache::Subscribe (GCSubscriptionPtr s)
+{
+  TRACEPRINTF (t, 4, "GroupCacheSubscribe %d ranges%s",
+               s->addrs.size(), s->changes_only ? ", changes only" : "");
+  new GCSubscriber(this, s);
+}
+
 class GCTracker : protected GroupCacheReader
 {
   GCLastCallback cb;
   ClientConnPtr cc;
-  ev::timer timeout;
+  ev::timer timeout {loop};
   Array < eibaddr_t > a;
   uint32_t start;
 public:
@@ -43,10 +43,46 @@ struct GroupCacheEntry
   time_t recvtime;
   /** seqnum */
   uint32_t seq;
+  /** read by a client since the eviction clock last passed */
+  bool referenced = false;
+  /** never evicted, not counted against max-size */
+  bool pinned = false;
+  /** the last update carried a different value than the one before */
+  bool changed = true;
 };
 
+/** recorded past values of one group address, oldest entry at pos once the ring is full */
+struct GroupCacheHistory
+{
+  Array<GroupCacheEntry> ring;
+  /** next slot to overwrite */
+  size_t pos = 0;
+};
+
+/** a range of group addresses */
+struct GroupAddrRange
+{
+  eibaddr_t lo;
+  eibaddr_t hi;
+};
+typedef Array<GroupAddrRange> GroupAddrRanges;
+
 typedef void (*GCReadCallback)(const GroupCacheEntry &foo, bool nowait, ClientConnPtr c);
 typedef void (*GCLastCallback)(const Array<eibaddr_t> &foo, uint32_t end, ClientConnPtr c);
+typedef void (*GCMultiCallback)(const Array<GroupCacheEntry> &foo, ClientConnPtr c);
+
+/** a client's standing request to be told about cache updates */
+struct GroupCacheSubscription
+{
+  /** group addresses to report; empty: all of them */
+  GroupAddrRanges addrs;
+  /** skip updates which repeat the cached value */
+  bool changes_only = false;
+  GCReadCallback cb = nullptr;
+  /** the subscriber; reset when it goes away */
+  ClientConnPtr cc;
+};
+typedef std::shared_ptr<GroupCacheSubscription> GCSubscriptionPtr;
 
 class GroupCacheReader
 {
@@ -66,6 +102,18 @@ typedef std::map<uint32_t, eibaddr_t> SeqMap;
 /** map group addresses to cache entries */
 typedef std::unordered_map<eibaddr_t, GroupCacheEntry> CacheMap;
 
+/** map group addresses to value history */
+typedef std::unordered_map<eibaddr_t, GroupCacheHistory> HistoryMap;
+
+/** which entry to drop when the cache is full */
+enum GroupCacheEviction
+{
+  /** the entry that has not been updated for the longest time */
+  GC_EVICT_OLDEST,
+  /** like OLDEST, but entries read by a client get a second chance */
+  GC_EVICT_CLOCK,
+};
+
 class GroupCache:public Driver
 {
   Array < GroupCacheReader * > reader;
@@ -77,6 +125,22 @@ class GroupCache:public Driver
   uint16_t maxsize;
   /** cached copy of main address */
   eibaddr_t addr;
+  /** number of past values to keep per group address; zero: no history */
+  uint16_t histsize = 0;
+  /** group addresses to keep a history for; empty: all of them */
+  GroupAddrRanges histaddrs;
+  /** The history */
+  HistoryMap history;
+  /** eviction policy */
+  GroupCacheEviction eviction = GC_EVICT_OLDEST;
+  /** group addresses which are never evicted */
+  GroupAddrRanges pinaddrs;
+  /** number of pinned entries in the cache */
+  size_t npinned = 0;
+  /** sequence number where the eviction clock continues */
+  uint32_t hand = 0;
+  /** statistics */
+  unsigned long hits = 0, misses = 0, evictions = 0;
 
 public: // but only for GroupCacheReader
   bool setup();
@@ -88,9 +152,19 @@ public: // but only for GroupCacheReader
   void addAddress (eibaddr_t addr UNUSED) { }
 
 private:
-  ev::async remtrigger; void remtrigger_cb(ev::async &w, int revents);
+  ev::async remtrigger {loop}; void remtrigger_cb(ev::async &w, int revents);
   /** signal that this entry has been updated */
   virtual void updated(GroupCacheEntry &);
+  /** send an A_GroupValue_Read to this address */
+  void sendRead (eibaddr_t addr);
+  /** drop one entry according to the eviction policy */
+  bool evict ();
+  /** look up an entry for a client, updating statistics */
+  CacheMap::iterator lookup (eibaddr_t addr, uint16_t age, time_t now);
+  /** append this entry to its address's history */
+  void addHistory (const GroupCacheEntry &);
+  /** parse a comma-separated list of group addresses and ranges */
+  bool readranges (const std::string& s, GroupAddrRanges& r);
 
 public:
   /** constructor */
@@ -122,6 +196,17 @@ public:
   /** read, and optionally wait for, a cache entry for this address */
   void Read (eibaddr_t addr, unsigned timeout, uint16_t age,
              GCReadCallback cb, ClientConnPtr c);
+  /** return all cache entries within a group address range */
+  void Dump (eibaddr_t start, eibaddr_t end,
+             GCMultiCallback cb, ClientConnPtr c);
+  /** read, and optionally wait for, cache entries for a list of addresses */
+  void ReadMulti (const Array<eibaddr_t> &addrs, unsigned timeout,
+                  uint16_t age, GCMultiCallback cb, ClientConnPtr c);
+  /** return the recorded history of an address */
+  void History (eibaddr_t addr, uint32_t start, time_t since,
+                GCMultiCallback cb, ClientConnPtr c);
+  /** report matching updates until the subscription's connection is reset */
+  void Subscribe (GCSubscriptionPtr s);
   /** incrementally monitor group cache updates */
   void LastUpdates (uint16_t start, uint8_t timeout,
                     GCLastCallback cb, ClientConnPtr c);
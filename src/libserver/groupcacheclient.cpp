@@ -90,6 +90,140 @@ LastUpdates2Callback(const Array<eibaddr_t> &addrs, uint32_t end, ClientConnPtr
   c->sendmessage (erg.size(), erg.data());
 }
 
+/** upper bound for the size of a single EIB_CACHE_ENTRIES message */
+#define ENTRIES_MAXLEN 4096
+
+void
+EntriesCallback(const Array<GroupCacheEntry> &entries, ClientConnPtr c)
+{
+  CArray erg;
+
+  erg.resize (2);
+  EIBSETTYPE (erg, EIB_CACHE_ENTRIES);
+  for (unsigned int i = 0; i < entries.size(); i++)
+    {
+      const GroupCacheEntry &gce = entries[i];
+      unsigned int pos = erg.size();
+
+      if (pos > 2 && pos + 5 + gce.data.size() > ENTRIES_MAXLEN)
+        {
+          c->sendmessage (erg.size(), erg.data());
+          erg.resize (2);
+          pos = 2;
+        }
+      erg.resize (pos + 5);
+      erg[pos] = (gce.src >> 8) & 0xff;
+      erg[pos + 1] = (gce.src >> 0) & 0xff;
+      erg[pos + 2] = (gce.dst >> 8) & 0xff;
+      erg[pos + 3] = (gce.dst >> 0) & 0xff;
+      erg[pos + 4] = gce.data.size();
+      erg.setpart (gce.data, pos + 5);
+    }
+  if (erg.size() > 2)
+    c->sendmessage (erg.size(), erg.data());
+
+  // an empty message terminates the sequence
+  erg.resize (2);
+  c->sendmessage (erg.size(), erg.data());
+}
+
+void
+HistoryCallback(const Array<GroupCacheEntry> &entries, ClientConnPtr c)
+{
+  CArray erg;
+
+  erg.resize (2);
+  EIBSETTYPE (erg, EIB_CACHE_HISTORY);
+  for (unsigned int i = 0; i < entries.size(); i++)
+    {
+      const GroupCacheEntry &gce = entries[i];
+      unsigned int pos = erg.size();
+      uint32_t tm = gce.recvtime;
+
+      erg.resize (pos + 11);
+      erg[pos] = (gce.seq >> 24) & 0xff;
+      erg[pos + 1] = (gce.seq >> 16) & 0xff;
+      erg[pos + 2] = (gce.seq >> 8) & 0xff;
+      erg[pos + 3] = (gce.seq >> 0) & 0xff;
+      erg[pos + 4] = (tm >> 24) & 0xff;
+      erg[pos + 5] = (tm >> 16) & 0xff;
+      erg[pos + 6] = (tm >> 8) & 0xff;
+      erg[pos + 7] = (tm >> 0) & 0xff;
+      erg[pos + 8] = (gce.src >> 8) & 0xff;
+      erg[pos + 9] = (gce.src >> 0) & 0xff;
+      erg[pos + 10] = gce.data.size();
+      erg.setpart (gce.data, pos + 11);
+    }
+  c->sendmessage (erg.size(), erg.data());
+}
+
+void
+SubscriptionCallback(const GroupCacheEntry &gce, bool nowait UNUSED, ClientConnPtr c)
+{
+  CArray erg;
+
+  erg.resize (6 + gce.data.size());
+  EIBSETTYPE (erg, EIB_GROUP_PACKET);
+  erg[2] = (gce.src >> 8) & 0xff;
+  erg[3] = (gce.src >> 0) & 0xff;
+  erg[4] = (gce.dst >> 8) & 0xff;
+  erg[5] = (gce.dst >> 0) & 0xff;
+  erg.setpart (gce.data, 6);
+  c->sendmessage (erg.size(), erg.data());
+}
+
+A_CacheSubscription::A_CacheSubscription (ClientConnPtr cc) : A__Base(cc)
+{
+  t->setAuxName("GCS");
+  TRACEPRINTF (t, 7, "OpenCacheSubscription");
+}
+
+A_CacheSubscription::~A_CacheSubscription ()
+{
+  TRACEPRINTF (con->t, 7, "CloseCacheSubscription");
+  stop();
+}
+
+bool
+A_CacheSubscription::setup (uint8_t *buf, size_t len)
+{
+  GroupCachePtr cache = con->router.getCache();
+
+  if (!cache || len < 3 || (len - 3) % 4)
+    {
+      TRACEPRINTF (t, 7, "OpenCacheSubscription bad, size %d", len);
+      return false;
+    }
+  s = GCSubscriptionPtr(new GroupCacheSubscription());
+  s->changes_only = buf[2] != 0;
+  for (unsigned int i = 3; i < len; i += 4)
+    {
+      GroupAddrRange r;
+      r.lo = (buf[i] << 8) | (buf[i + 1]);
+      r.hi = (buf[i + 2] << 8) | (buf[i + 3]);
+      s->addrs.push_back (r);
+    }
+  s->cb = &SubscriptionCallback;
+  s->cc = con;
+  cache->Subscribe (s);
+  con->sendmessage (2, buf);
+  return true;
+}
+
+void
+A_CacheSubscription::stop ()
+{
+  // the cache drops its reader on the next update
+  if (s)
+    s->cc = nullptr;
+}
+
+void
+A_CacheSubscription::recv_Data(uint8_t *buf UNUSED, size_t len UNUSED)
+{
+  on_error();
+}
+
 void
 GroupCacheRequest (ClientConnPtr c, uint8_t *buf, size_t len)
 {
@@ -177,6 +311,48 @@ GroupCacheRequest (ClientConnPtr c, uint8_t *buf, size_t len)
         break;
       }
 
+    case EIB_CACHE_DUMP:
+      {
+        eibaddr_t start = 0, end = 0xFFFF;
+        if (len >= 6)
+          {
+            start = (buf[2] << 8) | (buf[3]);
+            end = (buf[4] << 8) | (buf[5]);
+          }
+        cache->Dump (start, end, &EntriesCallback, c);
+        break;
+      }
+
+    case EIB_CACHE_READ_MULTI:
+      {
+        if (len < 5)
+          {
+            c->sendreject ();
+            return;
+          }
+        uint8_t timeout = buf[2];
+        Array<eibaddr_t> addrs;
+        age = (buf[3] << 8) | (buf[4]);
+        for (unsigned int i = 5; i + 1 < len; i += 2)
+          addrs.push_back ((buf[i] << 8) | (buf[i + 1]));
+        cache->ReadMulti (addrs, timeout, age, &EntriesCallback, c);
+        break;
+      }
+
+    case EIB_CACHE_HISTORY:
+      {
+        if (len < 12)
+          {
+            c->sendreject ();
+            return;
+          }
+        dst = (buf[2] << 8) | (buf[3]);
+        uint32_t start = (buf[4] << 24) | (buf[5] << 16) | (buf[6] << 8) | buf[7];
+        uint32_t since = (buf[8] << 24) | (buf[9] << 16) | (buf[10] << 8) | buf[11];
+        cache->History (dst, start, since, &HistoryCallback, c);
+        break;
+      }
+
     default:
       c->sendreject ();
     }
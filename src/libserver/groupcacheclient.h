@@ -22,6 +22,8 @@
 
 #include "link.h"
 #include "router.h"
+#include "connection.h"
+#include "groupcache.h"
 
 class ClientConnection;
 typedef std::shared_ptr<ClientConnection> ClientConnPtr;
@@ -30,4 +32,17 @@ bool CreateGroupCache (Router& r, IniSectionPtr& s);
 
 void GroupCacheRequest (ClientConnPtr c, uint8_t *buf, size_t len);
 
+/** implements client interface to a group cache subscription */
+class A_CacheSubscription : public A__Base
+{
+  GCSubscriptionPtr s;
+public:
+  A_CacheSubscription (ClientConnPtr cc);
+  virtual ~A_CacheSubscription ();
+  bool setup (uint8_t *buf,size_t len);
+  void stop();
+
+  void recv_Data(uint8_t *buf, size_t len); // to socket
+};
+
 #endif
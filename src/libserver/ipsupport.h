@@ -37,7 +37,7 @@ bool GetSourceAddress (TracePtr t, const struct sockaddr_in6 *dest, struct socka
 /** convert a to EIBnet/IP format */
 CArray IPtoEIBNetIP (const struct sockaddr_in *a, bool nat);
 /** convert EIBnet/IP IP Address to a */
-bool EIBnettoIP (const CArray & buf, struct sockaddr_in *a,
+bool EIBnettoIP (CArrayView buf, struct sockaddr_in *a,
 		const struct sockaddr_in *src, bool & nat);
 bool compareIPAddress (const struct sockaddr_in &a,
 		       const struct sockaddr_in &b);
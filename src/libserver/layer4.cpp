@@ -30,7 +30,7 @@ Layer4common<COMM>::~Layer4common() {}
 T_Broadcast::T_Broadcast (T_Reader<BroadcastComm> *app, LinkConnectClientPtr lc, bool write_only)
   : Layer4commonWO(app, lc,write_only)
 {
-  t->setAuxName("TBr");
+  setAuxName("TBr");
   TRACEPRINTF (t, 4, "OpenBroadcast %s", write_only ? "WO" : "RW");
 }
 
@@ -43,12 +43,10 @@ void
 T_Broadcast::send_L_Data (LDataPtr l)
 {
   BroadcastComm c;
-  TPDUPtr t = TPDU::fromPacket (l->data, this->t);
-  if (t->getType () == T_DATA_XXX_REQ)
+  if (TPDUView (l->data).getType () == T_DATA_XXX_REQ)
     {
-      T_DATA_XXX_REQ_PDU *t1 = (T_DATA_XXX_REQ_PDU *) &*t;
-      c.data = t1->data;
       c.src = l->source;
+      c.data = std::move (l->data);
       app->send(c);
     }
   send_Next();
@@ -77,7 +75,7 @@ T_Broadcast::recv_Data (const CArray & c)
 T_Group::T_Group (T_Reader<GroupComm> *app, LinkConnectClientPtr lc, eibaddr_t group, bool write_only)
   : Layer4commonWO(app, lc, write_only)
 {
-  t->setAuxName("TGr");
+  setAuxName("TGr");
   TRACEPRINTF (t, 4, "OpenGroup %s %s", FormatGroupAddr (group),
 	       write_only ? "WO" : "RW");
   groupaddr = group;
@@ -87,12 +85,10 @@ void
 T_Group::send_L_Data (LDataPtr l)
 {
   GroupComm c;
-  TPDUPtr t = TPDU::fromPacket (l->data, this->t);
-  if (t->getType () == T_DATA_XXX_REQ)
+  if (TPDUView (l->data).getType () == T_DATA_XXX_REQ)
     {
-      T_DATA_XXX_REQ_PDU *t1 = (T_DATA_XXX_REQ_PDU *) &*t;
-      c.data = t1->data;
       c.src = l->source;
+      c.data = std::move (l->data);
       app->send(c);
     }
   send_Next();
@@ -125,7 +121,7 @@ T_Group::~T_Group ()
 T_TPDU::T_TPDU (T_Reader<TpduComm> *app, LinkConnectClientPtr lc, eibaddr_t src)
   : Layer4common(app, lc)
 {
-  t->setAuxName("TPdu");
+  setAuxName("TPdu");
   TRACEPRINTF (t, 4, "OpenTPDU %s", FormatEIBAddr (src));
   this->src = src;
 }
@@ -164,7 +160,7 @@ T_TPDU::~T_TPDU ()
 T_Individual::T_Individual (T_Reader<CArray> *app, LinkConnectClientPtr lc, eibaddr_t dest, bool write_only)
   : Layer4commonWO(app, lc, write_only)
 {
-  t->setAuxName("TInd");
+  setAuxName("TInd");
   TRACEPRINTF (t, 4, "OpenIndividual %s %s",
                FormatEIBAddr (dest).c_str(), write_only ? "WO" : "RW");
   this->dest = dest;
@@ -211,7 +207,7 @@ T_Individual::~T_Individual ()
 T_Connection::T_Connection (T_Reader<CArray> *app, LinkConnectClientPtr lc, eibaddr_t d)
 	: Layer4common (app, lc)
 {
-  t->setAuxName("TConn");
+  setAuxName("TConn");
   TRACEPRINTF (t, 4, "OpenConnection %s", FormatEIBAddr (d));
   timer.set <T_Connection, &T_Connection::timer_cb> (this);
 
@@ -433,13 +429,11 @@ void
 GroupSocket::send_L_Data (LDataPtr l)
 {
   GroupAPDU c;
-  TPDUPtr t = TPDU::fromPacket (l->data, this->t);
-  if (t->getType () == T_DATA_XXX_REQ)
+  if (TPDUView (l->data).getType () == T_DATA_XXX_REQ)
     {
-      T_DATA_XXX_REQ_PDU *t1 = (T_DATA_XXX_REQ_PDU *) &*t;
-      c.data = t1->data;
       c.src = l->source;
       c.dst = l->dest;
+      c.data = std::move (l->data);
       app->send(c);
     }
   send_Next();
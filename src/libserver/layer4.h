@@ -181,7 +181,7 @@ typedef std::shared_ptr<T_Individual> T_IndividualPtr;
 /** implement a client T_Connection */
 class T_Connection:public Layer4common<CArray>
 {
-  ev::timer timer; void timer_cb(ev::timer &w, int revents);
+  ev::timer timer {loop}; void timer_cb(ev::timer &w, int revents);
 
   /** input queue */
   Queue < CArray > in;
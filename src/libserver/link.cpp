@@ -21,14 +21,16 @@
 #include "router.h"
 #include <stdio.h>
 
+thread_local unsigned long LinkBase::epoch = 1;
+
 LinkBase::~LinkBase() { }
 LinkRecv::~LinkRecv() { }
 Driver::~Driver() { }
 BusDriver::~BusDriver() { }
 SubDriver::~SubDriver() { }
 LineDriver::~LineDriver() { }
-LinkConnect_::~LinkConnect_() { }
-Filter::~Filter() { }
+LinkConnect_::~LinkConnect_() { stack_changed(); }
+Filter::~Filter() { stack_changed(); }
 Server::~Server() { }
 BaseRouter::~BaseRouter() { }
 LinkConnectClient::~LinkConnectClient() { }
@@ -78,10 +80,14 @@ LinkConnect::~LinkConnect()
     static_cast<Router &>(router).release_client_addr(addr);
 }
 
-LinkBase::LinkBase(BaseRouter& r UNUSED, IniSectionPtr& s, TracePtr tr) : cfg(s)
+LinkBase::LinkBase(BaseRouter& r UNUSED, IniSectionPtr& s, TracePtr tr, bool borrow) : cfg(s)
 {
-  t = TracePtr(new Trace(*tr, s));
-  t->setAuxName("Base");
+  if (borrow)
+    t = Trace::sub(tr);
+  else
+    t = TracePtr(new Trace(*tr, s));
+  borrowed = (t == tr);
+  setAuxName("Base");
 }
 
 std::string
@@ -409,6 +415,7 @@ LinkConnect::setup()
   retry_delay = cfg->value("retry-delay",0);
   max_retries = cfg->value("max-retry",0);
   send_timeout = cfg->value("send-timeout", 10);
+  recorder.setup(cfg->value("flight-recorder", recorder_frames));
   return true;
 }
 
@@ -503,6 +510,7 @@ LinkConnect::send_Next()
 void
 LinkConnect::send_L_Data (LDataPtr l)
 {
+  recorder.add(FlightRecorder::FR_OUT, *l, static_cast<Router&>(router).queued(), !send_more);
   send_more = false;
   assert (state == L_up);
   retry_timer.start(send_timeout,0);
@@ -519,12 +527,14 @@ LinkConnect::stopped()
 void
 LinkConnect::errored()
 {
+  recorder.dump(t, "errored");
   setState(L_error);
 }
 
 void
 LinkConnect::recv_L_Data (LDataPtr l)
 {
+  recorder.add(FlightRecorder::FR_IN, *l, static_cast<Router&>(router).queued(), !send_more);
   static_cast<Router&>(router).recv_L_Data(std::move(l), *this);
 }
 
@@ -554,6 +564,7 @@ LinkConnect_::checkSysGroupAddress(eibaddr_t addr)
 void
 LinkConnect::recv_L_Busmonitor (LBusmonPtr l)
 {
+  recorder.add(*l, static_cast<Router&>(router).queued());
   static_cast<Router&>(router).recv_L_Busmonitor(std::move(l));
 }
 
@@ -580,16 +591,16 @@ SubDriver::SubDriver(const LinkConnectClientPtr& c)
 }
 
 LineDriver::LineDriver(const LinkConnectClientPtr& c)
-      : Driver(c, c->cfg)
+      : Driver(c, c->cfg, true)
 {
-  t->setAuxName("LineDr");
+  setAuxName("LineDr");
   server = c->server;
 }
 
 void
 Driver::send_Next()
 {
-  auto r = recv.lock();
+  LinkRecv *r = recv.get();
   if (r != nullptr)
     r->send_Next();
 }
@@ -597,7 +608,7 @@ Driver::send_Next()
 void
 Driver::recv_L_Data (LDataPtr l)
 {
-  auto r = recv.lock();
+  LinkRecv *r = recv.get();
   if (r != nullptr)
     r->recv_L_Data(std::move(l));
 }
@@ -605,7 +616,7 @@ Driver::recv_L_Data (LDataPtr l)
 bool
 Driver::checkSysAddress(eibaddr_t addr)
 {
-  auto r = recv.lock();
+  LinkRecv *r = recv.get();
   if (r == nullptr)
     return false;
   return r->checkSysAddress(addr);
@@ -614,7 +625,7 @@ Driver::checkSysAddress(eibaddr_t addr)
 bool
 Driver::checkSysGroupAddress(eibaddr_t addr)
 {
-  auto r = recv.lock();
+  LinkRecv *r = recv.get();
   if (r == nullptr)
     return false;
   return r->checkSysGroupAddress(addr);
@@ -623,7 +634,7 @@ Driver::checkSysGroupAddress(eibaddr_t addr)
 void
 Filter::send_Next()
 {
-  auto r = recv.lock();
+  LinkRecv *r = recv.get();
   if (r != nullptr)
     r->send_Next();
 }
@@ -631,7 +642,7 @@ Filter::send_Next()
 void
 Filter::recv_L_Data (LDataPtr l)
 {
-  auto r = recv.lock();
+  LinkRecv *r = recv.get();
   if (r != nullptr)
     r->recv_L_Data(std::move(l));
 }
@@ -639,7 +650,7 @@ Filter::recv_L_Data (LDataPtr l)
 bool
 Filter::checkSysAddress(eibaddr_t addr)
 {
-  auto r = recv.lock();
+  LinkRecv *r = recv.get();
   if (r == nullptr)
     return false;
   return r->checkSysAddress(addr);
@@ -648,7 +659,7 @@ Filter::checkSysAddress(eibaddr_t addr)
 bool
 Filter::checkSysGroupAddress(eibaddr_t addr)
 {
-  auto r = recv.lock();
+  LinkRecv *r = recv.get();
   if (r == nullptr)
     return false;
   return r->checkSysGroupAddress(addr);
@@ -657,7 +668,7 @@ Filter::checkSysGroupAddress(eibaddr_t addr)
 void
 Driver::recv_L_Busmonitor (LBusmonPtr l)
 {
-  auto r = recv.lock();
+  LinkRecv *r = recv.get();
   if (r != nullptr)
     r->recv_L_Busmonitor(std::move(l)); 
 }
@@ -665,7 +676,7 @@ Driver::recv_L_Busmonitor (LBusmonPtr l)
 void
 Filter::recv_L_Busmonitor (LBusmonPtr l)
 {
-  auto r = recv.lock();
+  LinkRecv *r = recv.get();
   if (r != nullptr)
     r->recv_L_Busmonitor(std::move(l)); 
 }
@@ -744,6 +755,8 @@ Driver::push_filter(FilterPtr filter, bool first)
       t = shared_from_this();
     }
 
+  stack_changed();
+
   // link the first part
   if (!r->link(filter))
     return false;
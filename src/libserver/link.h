@@ -20,7 +20,9 @@
 #ifndef DRIVER_BASE_H
 #define DRIVER_BASE_H
 
+#include "addrset.h"
 #include "common.h"
+#include "flightrec.h"
 #include "inifile.h"
 #include "lpdu.h"
 
@@ -221,8 +223,15 @@ RegisterClass<T,I,N> AutoRegister<T,I,N>::ourRegisterer;
 class LinkBase : public std::enable_shared_from_this<LinkBase>
 {
 public:
-  LinkBase(BaseRouter &r, IniSectionPtr& s, TracePtr tr);
+  /** @borrow: use tr instead of a tracer of our own if possible,
+   * see Trace::sub(). Only for things configured by tr's section. */
+  LinkBase(BaseRouter &r, IniSectionPtr& s, TracePtr tr, bool borrow = false);
   virtual ~LinkBase();
+
+  /** Bumped whenever a link stack is re-linked or torn down.
+   * See LinkRecvRef. Per thread, like the links of a routing domain. */
+  static thread_local unsigned long epoch;
+  static void stack_changed() { epoch++; }
 private:
   /* DEBUG: Flag to make sure that the call sequence is observed */
   bool setup_called = false;
@@ -233,6 +242,14 @@ public:
 
   /** debug output */
   TracePtr t;
+  /** t belongs to someone else, see the constructor's @borrow */
+  bool borrowed = false;
+  /** t->setAuxName(), unless t is borrowed */
+  void setAuxName (const char *name)
+    {
+      if (!borrowed)
+        t->setAuxName(name);
+    }
 
   /** This thing's name; drivers/filters override this with their "real" name */
   virtual const std::string& name() { return cfg->name; }
@@ -331,6 +348,48 @@ public:
 };
 
 
+/** The pointer from a filter or driver to the next link up the stack.
+ *
+ * This is a weak pointer, but looking it up on every packet costs two
+ * atomic operations per hop. So we also cache the raw pointer. It's valid
+ * as long as LinkBase::epoch doesn't change: the LinkConnect at the bottom
+ * holds the whole stack, and anything that re-links or destroys a stack
+ * bumps the epoch.
+ */
+class LinkRecvRef
+{
+  std::weak_ptr<LinkRecv> p;
+  LinkRecv *raw = nullptr;
+  unsigned long epoch = 0;
+
+public:
+  LinkRecvRef& operator= (const LinkRecvPtr &r)
+    {
+      p = r;
+      raw = r.get();
+      epoch = LinkBase::epoch;
+      return *this;
+    }
+  void reset() { p.reset(); raw = nullptr; epoch = LinkBase::epoch; }
+
+  /** Slow path, for things that need to keep the link alive */
+  LinkRecvPtr lock() const { return p.lock(); }
+
+  /** Fast path for forwarding packets.
+   * Don't keep the result across calls that might change the stack.
+   * State changes may well do that, so they use lock(). */
+  LinkRecv *get()
+    {
+      if (epoch != LinkBase::epoch)
+        {
+          raw = p.lock().get();
+          epoch = LinkBase::epoch;
+        }
+      return raw;
+    }
+};
+
+
 /** This is the base class for LinkConnect, the bottom node of a filter stack.
  * This class separates the parts that are used in the global filter chain.
  */
@@ -438,8 +497,13 @@ public:
   int retries = 0;
   int max_retries = 0;
 
+  /** recent frames, dumped when this link fails */
+  FlightRecorder recorder;
+  /** its size unless "flight-recorder" says otherwise */
+  int recorder_frames = 32;
+
 private:
-  ev::timer retry_timer;
+  ev::timer retry_timer {loop};
   void retry_timer_cb(ev::timer &w, int revents);
 
   bool addr_local = true;
@@ -484,13 +548,20 @@ public:
   virtual const std::string& name() { return linkname; }
 };
 
-/** connection for a server's client with a single address */
+/** connection for a server's client with a single address.
+ *
+ * These are the links of knxd_unix and knxd_tcp clients, which may come
+ * and go by the thousands, so they are kept slim: no flight recorder
+ * unless the server's section asks for one, and the driver shares the
+ * link's tracer.
+ */
 class LinkConnectSingle : public LinkConnectClient
 {
 public:
   LinkConnectSingle(ServerPtr s, IniSectionPtr& c, TracePtr tr) : LinkConnectClient(s,c,tr)
     {
       t->setAuxName("ConnS");
+      recorder_frames = 0;
     }
   virtual ~LinkConnectSingle();
 
@@ -581,7 +652,7 @@ public:
 
 protected:
   /** Link to the receiver */
-  std::weak_ptr<LinkRecv> recv;
+  LinkRecvRef recv;
   /** Link to the LinkConnect object holding the stack this filter is in */
   std::weak_ptr<LinkConnect_> conn;
 public:
@@ -618,6 +689,7 @@ public:
         }
       send.reset();
       recv.reset();
+      stack_changed();
     }
 
   virtual void start() { if (send == nullptr) stopped(); else send->start(); }
@@ -659,16 +731,17 @@ public:
   /** Returns the driver's name, i.e. the config's driver= value */
   virtual const std::string& name();
 
-  Driver(const LinkConnectPtr_& c, IniSectionPtr& s) : LinkBase(c->router, s, c->t)
+  Driver(const LinkConnectPtr_& c, IniSectionPtr& s, bool borrow = false)
+      : LinkBase(c->router, s, c->t, borrow)
     {
       conn = c;
-      t->setAuxName("Driver");
+      setAuxName("Driver");
     }
   virtual ~Driver();
   std::weak_ptr<LinkConnect_> conn;
 
 protected:
-  std::weak_ptr<LinkRecv> recv;
+  LinkRecvRef recv;
 public:
   virtual void recv_L_Data (LDataPtr l);
   virtual void recv_L_Busmonitor (LBusmonPtr l);
@@ -710,18 +783,17 @@ public:
 
 class BusDriver : public Driver
 {
-  std::vector<bool> addrs;
+  AddrSet addrs;
 
 public:
   BusDriver(const LinkConnectPtr_& c, IniSectionPtr& s) : Driver(c,s)
     {
-      addrs.resize(65536);
       t->setAuxName("BusDriver");
     }
   virtual ~BusDriver();
 
-  virtual bool hasAddress(eibaddr_t addr) { return addrs[addr]; }
-  virtual void addAddress(eibaddr_t addr) { addrs[addr] = true; }
+  virtual bool hasAddress(eibaddr_t addr) { return addrs.has(addr); }
+  virtual void addAddress(eibaddr_t addr) { addrs.add(addr); }
   virtual bool checkAddress (eibaddr_t addr UNUSED) { return true; }
   virtual bool checkGroupAddress (eibaddr_t addr UNUSED) { return true; }
 };
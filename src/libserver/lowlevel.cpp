@@ -151,6 +151,12 @@ FDdriver::setup()
   if(!LowLevelDriver::setup())
     return false;
 
+  if (cfg->value("buffer-thread",false))
+    {
+      io_thread = std::unique_ptr<FDThread>(new FDThread(t));
+      if (!io_thread->setup(cfg))
+        return false;
+    }
   return true;
 }
 
@@ -158,6 +164,14 @@ void
 FDdriver::setup_buffers()
 {
   TRACEPRINTF (t, 2, "Buffer Setup on fd %d", fd);
+  if (io_thread)
+    {
+      io_thread->on_read.set<FDdriver,&FDdriver::read_cb>(this);
+      io_thread->on_error.set<FDdriver,&FDdriver::error_cb>(this);
+      if (!io_thread->start(fd))
+        errored();
+      return;
+    }
   sendbuf.init(fd);
   recvbuf.init(fd);
   recvbuf.low_latency();
@@ -181,6 +195,8 @@ FDdriver::~FDdriver ()
 {
   TRACEPRINTF (t, 2, "Close");
 
+  if (io_thread)
+    io_thread->stop();
   if (fd != -1)
     {
       sendbuf.stop(true);
@@ -193,7 +209,10 @@ void
 FDdriver::send_Data(CArray &c)
 {
   CArray *cp = new CArray(c);
-  sendbuf.write(cp);
+  if (io_thread)
+    io_thread->write(cp);
+  else
+    sendbuf.write(cp);
 }
 
 void
@@ -206,6 +225,8 @@ FDdriver::start()
 void
 FDdriver::stop()
 {
+  if (io_thread)
+    io_thread->stop();
   if (fd >= -1)
     {
       sendbuf.stop(true);
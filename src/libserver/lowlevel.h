@@ -24,6 +24,7 @@
 #include "link.h"
 #include "emi.h"
 #include "iobuf.h"
+#include "fdthread.h"
 
 /** Low level interface
  *
@@ -93,15 +94,16 @@ public:
   void send_Local (CArray& l, int raw = 0);
   virtual void do_send_Local (CArray& l, int raw = 0) { assert(!raw); send_Data(l); };
 
-  /* adapters for non-lvalue calls et al. */
+  /* adapters for non-lvalue calls et al.
+   * A temporary is ours to hand down, so don't copy it. */
   inline void do_send_Local (CArray&& l, int raw = 0) { do_send_Local(l, raw); };
-  inline void send_Local (CArray&& l, int raw = 0) { CArray lx = l; send_Local(lx, raw); }
-  inline void send_Data (CArray&& l) { CArray lx = l; send_Data(lx); }
-  inline void recv_Data (CArray&& l) { CArray lx = l; recv_Data(lx); }
+  inline void send_Local (CArray&& l, int raw = 0) { send_Local(l, raw); }
+  inline void send_Data (CArray&& l) { send_Data(l); }
+  inline void recv_Data (CArray&& l) { recv_Data(l); }
   inline void send_Data (unsigned char c) { CArray ca(&c,1); send_Data(ca); }
   inline void recv_Data (unsigned char c) { CArray ca(&c,1); recv_Data(ca); }
-  inline void send_Data (unsigned char *c, size_t len) { CArray ca(c,len); send_Data(ca); }
-  inline void recv_Data (unsigned char *c, size_t len) { CArray ca(c,len); send_Data(ca); }
+  inline void send_Data (const unsigned char *c, size_t len) { CArray ca(c,len); send_Data(ca); }
+  inline void recv_Data (const unsigned char *c, size_t len) { CArray ca(c,len); recv_Data(ca); }
 
   virtual FilterPtr findFilter(std::string name) = 0;
   virtual bool checkAddress(eibaddr_t addr) = 0;
@@ -112,7 +114,7 @@ public:
 protected:
   bool is_local = false;
 private:
-  ev::timer local_timeout; void local_timeout_cb(ev::timer &w, int revents);
+  ev::timer local_timeout {loop}; void local_timeout_cb(ev::timer &w, int revents);
 
   virtual void do_send_Next() = 0;
 };
@@ -196,6 +198,8 @@ protected:
   /** queueing */
   SendBuf sendbuf;
   RecvBuf recvbuf;
+  /** replaces sendbuf+recvbuf if the buffer-thread option is set */
+  std::unique_ptr<FDThread> io_thread;
   size_t read_cb(uint8_t *buf, size_t len);
   void error_cb();
 
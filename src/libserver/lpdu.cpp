@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include "lpdu.h"
 #include "tpdu.h"
+#include "apdu.h"
 
 LPDUPtr
 LPDU::fromPacket (const CArray & c, TracePtr t UNUSED)
@@ -64,7 +65,7 @@ CArray L_NACK_PDU::ToPacket ()
   return CArray (&c, 1);
 }
 
-String L_NACK_PDU::Decode (TracePtr t UNUSED)
+String L_NACK_PDU::Decode (TracePtr t UNUSED) const
 {
   return "NACK";
 }
@@ -89,7 +90,7 @@ CArray L_ACK_PDU::ToPacket ()
   return CArray (&c, 1);
 }
 
-String L_ACK_PDU::Decode (TracePtr t UNUSED)
+String L_ACK_PDU::Decode (TracePtr t UNUSED) const
 {
   return "ACK";
 }
@@ -114,7 +115,7 @@ CArray L_BUSY_PDU::ToPacket ()
   return CArray (&c, 1);
 }
 
-String L_BUSY_PDU::Decode (TracePtr t UNUSED)
+String L_BUSY_PDU::Decode (TracePtr t UNUSED) const
 {
   return "BUSY";
 }
@@ -139,15 +140,15 @@ L_Unknown_PDU::ToPacket ()
 }
 
 String
-L_Unknown_PDU::Decode (TracePtr t UNUSED)
+L_Unknown_PDU::Decode (TracePtr t UNUSED) const
 {
   String s ("Unknown LPDU: ");
 
   if (pdu.size() == 0)
     return "empty LPDU";
 
-  ITER (i,pdu)
-    addHex (s, *i);
+  for (unsigned int i = 0; i < pdu.size(); i++)
+    addHex (s, pdu[i]);
 
   return s;
 }
@@ -176,21 +177,33 @@ L_Busmonitor_PDU::ToPacket ()
 }
 
 String
-L_Busmonitor_PDU::Decode (TracePtr t)
+L_Busmonitor_PDU::Decode (TracePtr t) const
 {
   String s ("LPDU: ");
 
   if (pdu.size() == 0)
     return "empty LPDU";
 
-  ITER (i,pdu)
-    addHex (s, *i);
+  for (unsigned int i = 0; i < pdu.size(); i++)
+    addHex (s, pdu[i]);
   s += ":";
   LPDUPtr l = LPDU::fromPacket (pdu, t);
   s += l->Decode (t);
   return s;
 }
 
+const String&
+L_Busmonitor_PDU::text (TracePtr t) const
+{
+  if (!decoded.valid || decoded.key != pdu)
+    {
+      decoded.text = Decode (t);
+      decoded.key = pdu;
+      decoded.valid = true;
+    }
+  return decoded.text;
+}
+
 /* L_Data */
 
 L_Data_PDU::L_Data_PDU () : LPDU()
@@ -337,7 +350,7 @@ CArray L_Data_PDU::ToPacket ()
   return pdu;
 }
 
-String L_Data_PDU::Decode (TracePtr t)
+String L_Data_PDU::Decode (TracePtr t) const
 {
   assert (data.size() >= 1);
   assert (data.size() <= 0xff);
@@ -373,7 +386,33 @@ String L_Data_PDU::Decode (TracePtr t)
                     FormatEIBAddr (dest));
   s += " hops: ";
   addHex (s, hopcount);
+  if (TPDUView (data).getType () == T_DATA_XXX_REQ)
+    {
+      // skip the TPDU object, this is by far the most common case
+      s += "T_DATA_XXX_REQ ";
+      s += APDU::fromPacket (data, t)->Decode (t);
+      return s;
+    }
   TPDUPtr d = TPDU::fromPacket (data, t);
   s += d->Decode (t);
   return s;
 }
+
+const String&
+L_Data_PDU::text (TracePtr t) const
+{
+  /* everything Decode() looks at */
+  uint64_t hdr = uint64_t(source) | uint64_t(dest) << 16
+                 | uint64_t(hopcount) << 32 | uint64_t(prio) << 40
+                 | uint64_t(AddrType) << 48
+                 | uint64_t(repeated | valid_length << 1 | valid_checksum << 2) << 56;
+
+  if (!decoded.valid || decoded.hdr != hdr || decoded.key != data)
+    {
+      decoded.text = Decode (t);
+      decoded.hdr = hdr;
+      decoded.key = data;
+      decoded.valid = true;
+    }
+  return decoded.text;
+}
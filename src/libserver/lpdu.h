@@ -31,6 +31,7 @@ typedef std::unique_ptr<L_Busmonitor_PDU> LBusmonPtr;
 
 #include "common.h"
 #include "link.h"
+#include "pool.h"
 
 /** enumartion of Layer 2 frame types*/
 typedef enum
@@ -52,6 +53,29 @@ typedef enum
 }
 LPDU_Type;
 
+/** Decode() output of a frame, kept for whoever wants it next.
+ * Frames are modified on their way through knxd, so the text is only
+ * reused while the frame still has the content it was made from.
+ * Copies of a frame start without it: the router copies every frame
+ * it forwards, and most of them are never shown. */
+struct DecodedText
+{
+  /** header fields of an L_Data frame */
+  uint64_t hdr = 0;
+  /** payload (L_Data) or frame (L_Busmonitor) */
+  CArray key;
+  String text;
+  bool valid = false;
+
+  DecodedText () { }
+  DecodedText (const DecodedText &) { }
+  DecodedText & operator= (const DecodedText &)
+  {
+    valid = false;
+    return *this;
+  }
+};
+
 /** represents a Layer 2 frame */
 class LPDU
 {
@@ -63,7 +87,7 @@ public:
   /** convert to a character array */
   virtual CArray ToPacket () = 0;
   /** decode content as string */
-  virtual String Decode (TracePtr t) = 0;
+  virtual String Decode (TracePtr t) const = 0;
   /** get frame type */
   virtual LPDU_Type getType () const = 0;
   /** converts a character array to a Layer 2 frame */
@@ -82,7 +106,7 @@ public:
 
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode (TracePtr t);
+  String Decode (TracePtr t) const;
   LPDU_Type getType () const
   {
     return L_Unknown;
@@ -91,7 +115,7 @@ public:
 
 /* L_Data */
 
-class L_Data_PDU:public LPDU
+class L_Data_PDU:public LPDU, public Pooled<L_Data_PDU>
 {
 public:
   /** priority*/
@@ -113,16 +137,22 @@ public:
 
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode (TracePtr t);
+  String Decode (TracePtr t) const;
+  /** Decode(), but only computed once for all the text busmonitors,
+   * log filters and trace messages which show this frame. */
+  const String& text (TracePtr t) const;
   LPDU_Type getType () const
   {
     return (valid_length ? L_Data : L_Data_Part);
   }
+
+private:
+  mutable DecodedText decoded;
 };
 
 /* L_Busmonitor */
 
-class L_Busmonitor_PDU:public LPDU
+class L_Busmonitor_PDU:public LPDU, public Pooled<L_Busmonitor_PDU>
 {
 public:
   /** content of the TP1 frame */
@@ -130,15 +160,25 @@ public:
   uint8_t status;
   uint32_t timestamp;
 
+  /** Client messages for this frame, one per busmonitor format.
+   * Built on demand by the first client which needs one; the others
+   * share it. See A_Busmonitor. */
+  mutable CArray client_msg[3];
+
   L_Busmonitor_PDU ();
 
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode (TracePtr t);
+  String Decode (TracePtr t) const;
+  /** Decode(), computed once; see L_Data_PDU::text() */
+  const String& text (TracePtr t) const;
   LPDU_Type getType () const
   {
     return L_Busmonitor;
   }
+
+private:
+  mutable DecodedText decoded;
 };
 
 class L_ACK_PDU:public LPDU
@@ -149,7 +189,7 @@ public:
 
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode (TracePtr t);
+  String Decode (TracePtr t) const;
   LPDU_Type getType () const
   {
     return L_ACK;
@@ -164,7 +204,7 @@ public:
 
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode (TracePtr t);
+  String Decode (TracePtr t) const;
   LPDU_Type getType () const
   {
     return L_NACK;
@@ -179,7 +219,7 @@ public:
 
   bool init (const CArray & c);
   CArray ToPacket ();
-  String Decode (TracePtr t);
+  String Decode (TracePtr t) const;
   LPDU_Type getType () const
   {
     return L_BUSY;
@@ -192,8 +232,9 @@ class L_Busmonitor_CallBack
 public:
   L_Busmonitor_CallBack(std::string& n) : name(n) { }
   std::string& name;
-  /** callback: a bus monitor frame has been received */
-  virtual void send_L_Busmonitor (LBusmonPtr l) = 0;
+  /** callback: a bus monitor frame has been received.
+   * The frame is shared by all callbacks and only valid during the call. */
+  virtual void send_L_Busmonitor (const L_Busmonitor_PDU &l) = 0;
 };
 
 #endif
@@ -189,10 +189,9 @@ Router::setup()
     {
       if (!readaddrblock(x,client_addrs_start,client_addrs_len))
         goto ex;
-      client_addrs_pos = client_addrs_len-1;
-      client_addrs.resize(client_addrs_len);
-      ITER(i,client_addrs)
-        *i = false;
+      client_addrs.assign(client_addrs_len, false);
+      for (int i = 0; i < client_addrs_len; i++)
+        client_addrs_free.push(i);
     }
 
 #ifdef HAVE_GROUPCACHE
@@ -278,7 +277,7 @@ Router::setup()
       goto ex;
     }
 
-  if (ini.list_unseen(&unseen_lister, (void *)this))
+  if (check_unseen && ini.list_unseen(&unseen_lister, (void *)this))
     goto ex;
 
   ITER(i,links)
@@ -681,6 +680,9 @@ Router::~Router()
 //    delete i->second;
   links.clear();
 
+  TRACEPRINTF (t, 4, "frame pool: %lu/%lu data, %lu/%lu busmonitor (hits/misses)",
+               L_Data_PDU::stats.hits.load(), L_Data_PDU::stats.misses.load(),
+               L_Busmonitor_PDU::stats.hits.load(), L_Busmonitor_PDU::stats.misses.load());
   TRACEPRINTF (t, 4, "deleted.");
 }
 
@@ -716,7 +718,7 @@ Router::recv_L_Data (LDataPtr l, LinkConnect& link)
     { // check if from the correct interface
       if (&*l2x != &link)
         {
-          TRACEPRINTF (link.t, 3, "Packet not from %d:%s: %s", l2x->t->seq, l2x->t->name, l->Decode (t));
+          TRACEPRINTF (link.t, 3, "Packet not from %d:%s: %s", l2x->t->seq, l2x->t->name, l->text (t));
           return;
         }
     }
@@ -748,7 +750,7 @@ Router::queue_L_Data (LDataPtr l)
         trigger.send();
     }
   else
-    TRACEPRINTF (t, 9, "Queue: discard (not running) %s", l->Decode (t));
+    TRACEPRINTF (t, 9, "Queue: discard (not running) %s", l->text (t));
 }
 
 void
@@ -761,7 +763,7 @@ Router::queue_L_Busmonitor (LBusmonPtr l)
         mtrigger.send();
     }
   else
-    TRACEPRINTF (t, 9, "MonQueue: discard (not running) %s", l->Decode (t));
+    TRACEPRINTF (t, 9, "MonQueue: discard (not running) %s", l->text (t));
 }
 
 bool
@@ -938,28 +940,25 @@ eibaddr_t
 Router::get_client_addr (TracePtr t)
 {
   /*
-   * Start allocating after the last-assigned address.
+   * Released addresses are queued behind all other free ones.
    * This leaves a buffer for delayed replies so that they don't get sent
    * to a new client.
    *
-   * client_addrs_pos is set to len-1 in set_client_block() so that allocation
-   * still starts at the first free address when starting up.
+   * An address that some link already uses (e.g. one that's assigned by
+   * a remote tunnel server) is skipped and goes to the end of the queue.
    */
-  for (int i = 1; i <= client_addrs_len; i++)
+  for (size_t n = client_addrs_free.size(); n > 0; n--)
     {
-      unsigned int pos = (client_addrs_pos + i) % client_addrs_len;
-      if (client_addrs[pos])
-        continue;
+      uint16_t pos = client_addrs_free.get();
       eibaddr_t a = client_addrs_start + pos;
       LinkConnectPtr link = nullptr;
       if (a != addr && !hasAddress (a, link, true))
         {
           TRACEPRINTF (t, 3, "Allocate %s", FormatEIBAddr (a));
-          /* remember for next pass */
-          client_addrs_pos = pos;
           client_addrs[pos] = true;
           return a;
         }
+      client_addrs_free.push(pos);
     }
 
   /* no more … */
@@ -989,6 +988,7 @@ Router::release_client_addr(eibaddr_t addr)
 
   TRACEPRINTF (t, 3, "Release %s", FormatEIBAddr (addr));
   client_addrs[pos] = false;
+  client_addrs_free.push(pos);
 }
 
 void
@@ -1000,15 +1000,15 @@ Router::trigger_cb (ev::async &w UNUSED, int revents UNUSED)
 
       if (vbusmonitor.size())
         {
-          LBusmonPtr l2 = LBusmonPtr(new L_Busmonitor_PDU ());
-          l2->pdu.set (l1->ToPacket ());
+          L_Busmonitor_PDU l2;
+          l2.pdu = l1->ToPacket ();
 
           ITER(i,vbusmonitor)
-            i->cb->send_L_Busmonitor (LBusmonPtr(new L_Busmonitor_PDU (*l2)));
+            i->cb->send_L_Busmonitor (l2);
         }
       if (!l1->hopcount)
         {
-          TRACEPRINTF (t, 3, "Hopcount zero: %s", l1->Decode (t));
+          TRACEPRINTF (t, 3, "Hopcount zero: %s", l1->text (t));
           goto next;
         }
       if (l1->hopcount < 7 || !force_broadcast)
@@ -1020,7 +1020,7 @@ Router::trigger_cb (ev::async &w UNUSED, int revents UNUSED)
           ITER (i,ignore)
             if (d1 == i->data)
               {
-                TRACEPRINTF (t, 9, "Drop: %s", l1->Decode (t));
+                TRACEPRINTF (t, 9, "Drop: %s", l1->text (t));
                 goto next;
               }
         }
@@ -1125,9 +1125,9 @@ Router::mtrigger_cb (ev::async &w UNUSED, int revents UNUSED)
     {
       LBusmonPtr l1 = mbuf.get ();
 
-      TRACEPRINTF (t, 3, "RecvMon %s", l1->Decode (t));
+      TRACEPRINTF (t, 3, "RecvMon %s", l1->text (t));
       ITER (i, busmonitor)
-        i->cb->send_L_Busmonitor (LBusmonPtr(new L_Busmonitor_PDU (*l1)));
+        i->cb->send_L_Busmonitor (*l1);
     }
 }
 
@@ -1155,6 +1155,13 @@ Router::hasClientAddrs(bool complain)
 
 }
 
+void
+Router::dump_recorders(const char *reason)
+{
+  ITER(i, links)
+    i->second->recorder.dump(i->second->t, reason);
+}
+
 void
 RouterHigh::started()
 {
@@ -1181,7 +1188,7 @@ RouterHigh::errored()
 void
 RouterHigh::recv_L_Data (LDataPtr l)
 {
-  auto r = recv.lock();
+  LinkRecv *r = recv.get();
   if (r != nullptr)
     r->recv_L_Data(std::move(l));
 }
@@ -1189,7 +1196,7 @@ RouterHigh::recv_L_Data (LDataPtr l)
 void
 RouterHigh::recv_L_Busmonitor (LBusmonPtr l)
 {
-  auto r = recv.lock();
+  LinkRecv *r = recv.get();
   if (r != nullptr)
     r->recv_L_Busmonitor(std::move(l));
 }
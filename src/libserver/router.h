@@ -167,13 +167,13 @@ private:
   Queue<LinkConnectPtr> linkChanges;
 
   // libev
-  ev::async trigger;
+  ev::async trigger {loop};
   void trigger_cb (ev::async &w, int revents);
-  ev::async mtrigger;
+  ev::async mtrigger {loop};
   void mtrigger_cb (ev::async &w, int revents);
-  ev::async state_trigger;
+  ev::async state_trigger {loop};
   void state_trigger_cb (ev::async &w, int revents);
-  ev::timer start_timer;
+  ev::timer start_timer {loop};
   void start_timer_cb (ev::timer &w, int revents);
   float start_timeout;
 
@@ -187,12 +187,21 @@ private:
   eibaddr_t client_addrs_start;
   /** Length of address block to assign dynamically to clients */
   int client_addrs_len = 0;
-  int client_addrs_pos;
+  /** which of these are in use */
   std::vector<bool> client_addrs;
+  /** free addresses (as offsets into the block), in the order in which
+   * they'll be handed out. Released addresses go to the end, so they're
+   * not reused until every other free address has been. */
+  Queue < uint16_t > client_addrs_free;
 
 public:
   bool hasClientAddrs(bool complain = true);
 
+  /** frames waiting to be distributed to the links */
+  unsigned int queued() { return buf.size() + mbuf.size(); }
+  /** print every link's flight recorder */
+  void dump_recorders(const char *reason);
+
 private:
   /** busmonitor callbacks */
   Array < Busmonitor_Info > busmonitor;
@@ -222,6 +231,9 @@ public:
 
   /** allow unparsed tags in the config file? */
   bool unknown_ok = false;
+  /** look for unparsed tags at the end of setup()? Routing domains
+   * leave that to the main router, which is set up after them. */
+  bool check_unseen = true;
   /** flag whether systemd has passed us any file descriptors */
   bool using_systemd = false;
 
@@ -229,7 +241,7 @@ public:
   bool isRunning() { return all_running; }
 
 private:
-  ev::async cleanup;
+  ev::async cleanup {loop};
   void cleanup_cb (ev::async &w, int revents);
   /** to-be-closed client connections*/
   Queue < LinkBasePtr > cleanup_q;
@@ -38,12 +38,12 @@ public:
   bool ignore_when_systemd = false;
 
 private:
-  ev::io io; void io_cb (ev::io &w, int revents);
+  ev::io io {loop}; void io_cb (ev::io &w, int revents);
 
   /** open client connections*/
   Array < ClientConnPtr > connections;
 
-  ev::async cleanup;
+  ev::async cleanup {loop};
   void cleanup_cb (ev::async &w, int revents);
 
   /** to-be-closed client connections*/
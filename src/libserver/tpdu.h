@@ -45,6 +45,59 @@ TPDU_Type;
 class TPDU;
 typedef std::unique_ptr<TPDU> TPDUPtr;
 
+/** read-only view of a TPDU inside a packet; classifies it without
+ * allocating a TPDU object or copying the data.
+ * The packet must outlive the view. */
+class TPDUView
+{
+  const uchar *p;
+  size_t len;
+public:
+  TPDUView (const CArray & c) : p(c.data()), len(c.size()) { }
+
+  /** gets TPDU type, like TPDU::fromPacket(c)->getType() */
+  TPDU_Type getType () const
+  {
+    if (len < 1)
+      return T_UNKNOWN;
+    if ((p[0] & 0xfc) == 0)
+      return T_DATA_XXX_REQ;
+    if ((p[0] & 0xC0) == 0x40)
+      return T_DATA_CONNECTED_REQ;
+    if (len != 1)
+      return T_UNKNOWN;
+    if (p[0] == 0x80)
+      return T_CONNECT_REQ;
+    if (p[0] == 0x81)
+      return T_DISCONNECT_REQ;
+    if ((p[0] & 0xC3) == 0xC2)
+      return T_ACK;
+    if ((p[0] & 0xC3) == 0xC3)
+      return T_NACK;
+    return T_UNKNOWN;
+  }
+  /** transport control field, without the APCI bits */
+  uchar tpci () const { return len ? p[0] & 0xfc : 0; }
+  /** true if there is an APCI */
+  bool hasAPCI () const { return len >= 2; }
+  /** the 10-bit APCI, including any short data; needs hasAPCI() */
+  uint16_t apci () const { return ((p[0] & 0x03) << 8) | p[1]; }
+  /** the 6 data bits in the second APCI byte; needs hasAPCI() */
+  uchar shortData () const { return p[1] & 0x3f; }
+  /** data following the APCI */
+  const uchar *payload () const { return len > 2 ? p + 2 : nullptr; }
+  size_t payloadSize () const { return len > 2 ? len - 2 : 0; }
+
+  /** true for connectionless A_GroupValue_Read/Response/Write */
+  bool isGroupValue () const
+  {
+    return len >= 2 && (p[0] & 0xfc) == 0 && (apci () & 0x3C0) <= 0x080;
+  }
+  bool isGroupRead () const { return isGroupValue () && (apci () & 0x3C0) == 0x000; }
+  bool isGroupResponse () const { return isGroupValue () && (apci () & 0x3C0) == 0x040; }
+  bool isGroupWrite () const { return isGroupValue () && (apci () & 0x3C0) == 0x080; }
+};
+
 /** represents a TPDU */
 class TPDU
 {
@@ -20,23 +20,18 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <sys/time.h>
+#include <errno.h>
+#include <string.h>
 
 #include "trace.h"
 
-static bool trace_started = false;
+static std::atomic<bool> trace_started {false};
 
-unsigned int trace_seq = 0;
-unsigned int trace_namelen = 3;
+std::atomic<unsigned int> trace_seq {0};
+std::atomic<unsigned int> trace_namelen {3};
 
-std::string Trace::fullname()
-{
-  if (!auxname.length())
-    return name;
-  return name+'/'+auxname;
-}
-
-void
-Trace::TraceHeader (int layer)
+size_t
+Trace::Header (char *buf, size_t size, int layer)
 {
   struct timeval tv;
   gettimeofday(&tv, NULL);
@@ -47,17 +42,25 @@ Trace::TraceHeader (int layer)
   tv.tv_usec -= started.tv_usec;
   tv.tv_sec -= started.tv_sec;
 
-  if (!trace_started) {
-      trace_started = true;
-      setvbuf(stdout, NULL, _IOLBF, 0);
-      setvbuf(stderr, NULL, _IOLBF, 0);
-  }
+  size_t len = 0;
   if (servername.length())
-    fmt::printf("%s: ",servername);
+    len = trace_format (buf, size, "%s: ", servername);
   if (timestamps)
-    fmt::printf ("Layer %d [%2d:%-*s %u.%03u] ", layer, seq, trace_namelen, fullname(), (unsigned int)tv.tv_sec,(unsigned int)tv.tv_usec/1000);
+    len += trace_format (buf + len, size - len, "Layer %d [%2d:%-*s %u.%03u] ", layer, seq, trace_namelen.load(), fullname(), (unsigned int)tv.tv_sec,(unsigned int)tv.tv_usec/1000);
   else
-    fmt::printf ("Layer %d [%2d:%s] ", layer, seq, fullname());
+    len += trace_format (buf + len, size - len, "Layer %d [%2d:%s] ", layer, seq, fullname());
+  return len;
+}
+
+void
+Trace::TraceHeader (int layer)
+{
+  if (!trace_started.exchange(true)) {
+      setvbuf(stdout, NULL, _IOLBF, 0);
+      setvbuf(stderr, NULL, _IOLBF, 0);
+  }
+  char buf[AsyncLog::slot_size];
+  fwrite (buf, 1, Header(buf, sizeof(buf), layer), stdout);
 }
 
 void
@@ -65,6 +68,25 @@ Trace::TracePacketUncond (int layer, const char *msg, int Len,
 			  const uchar * data)
 {
   int i;
+  if (binary)
+    {
+      BinTrace::instance().packet(layer, seq, fullname(), msg, data, Len);
+      return;
+    }
+  if (async)
+    {
+      AsyncLog::Msg m;
+      if (!AsyncLog::instance().reserve(m, 1))
+        return;
+      size_t size = AsyncLog::slot_size - 1;
+      size_t len = Header(m.data, size, layer);
+      len += trace_format (m.data + len, size - len, "%s(%03d):", msg, Len);
+      for (i = 0; i < Len && len < size; i++)
+        len += trace_format (m.data + len, size - len, " %02X", data[i]);
+      m.data[len++] = '\n';
+      AsyncLog::instance().commit(m, len);
+      return;
+    }
   TraceHeader(layer);
   fmt::printf ("%s(%03d):", msg, Len);
   for (i = 0; i < Len; i++)
@@ -99,9 +121,20 @@ error_level(std::string level, int def)
 void
 Trace::setup()
 {
+  full = name;
   if (trace_namelen < this->name.length())
     trace_namelen = this->name.length();
   timestamps = cfg->value("timestamps",timestamps);
+  async = cfg->value("async-log",async);
+  if (async)
+    AsyncLog::instance().setup(cfg->value("async-log-size",1024));
+  std::string tracefile = cfg->value("trace-file","");
+  if (tracefile.size())
+    {
+      binary = BinTrace::instance().open(tracefile, (size_t)cfg->value("trace-file-size",4096) * 1024);
+      if (!binary)
+        std::cerr << "Cannot create trace file " << tracefile << ": " << strerror(errno) << std::endl;
+    }
   layers = cfg->value("trace-mask",(int)layers);
   int nlevel = error_level(cfg->value("error-level",""),level);
   if (nlevel == -1)
@@ -113,15 +146,27 @@ Trace::setup()
   setAuxName(cfg->value("name",name));
 }
 
+TracePtr
+Trace::sub (TracePtr tr, const std::string& name, const std::string& aux)
+{
+  if (!tr->layers && name.empty())
+    return tr;
+  TracePtr t = std::make_shared<Trace>(*tr, name);
+  if (aux.size())
+    t->setAuxName(aux);
+  return t;
+}
+
 void
 Trace::setAuxName(std::string name)
 {
   if (name == this->name)
     return;
 
-  unsigned int len = this->name.length()+auxname.length()+(auxname.length()>0);
   this->auxname = name;
+  full = auxname.length() ? this->name+'/'+auxname : this->name;
 
+  unsigned int len = full.length();
   if (trace_namelen < len)
     trace_namelen = len;
 }
@@ -22,11 +22,14 @@
 
 #include <stdarg.h>
 #include <sys/time.h>
+#include <atomic>
 #include <memory>
 #include <iostream>
 #include <fmt/format.h>
 #include "common.h"
 #include "inifile.h"
+#include "asynclog.h"
+#include "bintrace.h"
 
 #include "config.h"
 #if HAVE_FMT_PRINTF
@@ -50,10 +53,33 @@
 #define E_NOTICE (LEVEL_NOTICE<<28)
 #define E_INFO (LEVEL_INFO<<28)
 
-extern unsigned int trace_seq;
-extern unsigned int trace_namelen;
+/* routing domains create tracers in threads of their own */
+extern std::atomic<unsigned int> trace_seq;
+extern std::atomic<unsigned int> trace_namelen;
+
+/** like snprintf, for fmt's printf syntax; doesn't allocate
+ * @return the number of bytes written, at most size */
+template <typename... Args>
+size_t
+trace_format (char *buf, size_t size, const char *msg, const Args & ... args)
+{
+#if FMT_VERSION >= 90000
+  fmt::detail::iterator_buffer<char *, char, fmt::detail::fixed_buffer_traits> b(buf, size);
+  fmt::detail::vprintf (b, fmt::string_view (msg),
+      fmt::basic_format_args<fmt::printf_context> (fmt::make_printf_args (args...)));
+  return std::min (b.count(), size);
+#else
+  std::string s = fmt::sprintf (msg, args...);
+  size_t len = std::min (s.size(), size);
+  memcpy (buf, s.data(), len);
+  return len;
+#endif
+}
 
 /** implements debug output with different levels */
+class Trace;
+typedef std::shared_ptr<Trace> TracePtr;
+
 class Trace
 {
   /** message levels to print */
@@ -64,7 +90,13 @@ class Trace
   struct timeval started;
   /** print timestamps when tracing */
   bool timestamps = true;
+  /** hand output to the AsyncLog writer thread */
+  bool async = false;
+  /** write trace messages to the BinTrace file instead */
+  bool binary = false;
 
+  /** write the common header to buf, truncating at size */
+  size_t Header (char *buf, size_t size, int layer);
   /** print the common header */
   void TraceHeader (int layer);
 
@@ -72,6 +104,8 @@ class Trace
 
   void setup();
 
+  std::string full;
+
 public:
   /** set a new name */
   void setAuxName(std::string name);
@@ -82,7 +116,8 @@ public:
   std::string servername;
   std::string name;
   std::string auxname;
-  std::string fullname();
+  /** name/auxname, kept so that tracing doesn't have to build it */
+  const std::string& fullname() const { return full; }
 
   unsigned int seq;
 
@@ -101,6 +136,8 @@ public:
     this->name = name.length() ? name : orig.name;
     this->started = orig.started;
     this->timestamps = orig.timestamps;
+    this->async = orig.async;
+    this->binary = orig.binary;
     this->seq = ++trace_seq;
     setup();
   }
@@ -112,6 +149,8 @@ public:
     this->name = s->name;
     this->started = orig.started;
     this->timestamps = orig.timestamps;
+    this->async = orig.async;
+    this->binary = orig.binary;
     this->seq = ++trace_seq;
     setup();
   }
@@ -120,6 +159,14 @@ public:
   {
   }
 
+  /** A tracer for something which lives and dies with a client
+   * connection. There may be many thousands of those, so unless
+   * trace messages are switched on or it needs a @name of its own,
+   * it simply uses @tr. @aux is the new tracer's aux name; a shared
+   * tracer keeps its own. */
+  static TracePtr sub (TracePtr tr, const std::string& name = "",
+                       const std::string& aux = "");
+
   /** sets trace level */
   inline void SetTraceLevel (int l)
   {
@@ -175,6 +222,23 @@ public:
   template <typename... Args>
   void TracePrintf (int layer, const char *msg, const Args & ... args)
     {
+        if (binary)
+          {
+            BinTrace::instance().record(BT_TRACE, layer, seq, 0, fullname(), msg, args ...);
+            return;
+          }
+        if (async)
+          {
+            AsyncLog::Msg m;
+            if (!AsyncLog::instance().reserve(m, 1))
+              return;
+            size_t size = AsyncLog::slot_size - 1;
+            size_t len = Header(m.data, size, layer);
+            len += trace_format(m.data + len, size - len, msg, args ...);
+            m.data[len++] = '\n';
+            AsyncLog::instance().commit(m, len);
+            return;
+          }
         TraceHeader(layer);
         fmt::fprintf(stdout, msg, args ...);
         fmt::printf ("\n");
@@ -188,6 +252,23 @@ public:
   void ErrorPrintfUncond (unsigned int msgid, const char *msg, const Args & ... args)
     {
       char c = get_level_char((msgid >> 28) & 0x0f); 
+      if (binary)
+        BinTrace::instance().record(BT_ERROR, (msgid >> 28) & 0x0f, seq, msgid & 0xffffff, name, msg, args ...);
+      if (async)
+        {
+          AsyncLog::Msg m;
+          if (!AsyncLog::instance().reserve(m, 2))
+            return;
+          size_t size = AsyncLog::slot_size - 1;
+          size_t len = 0;
+          if (servername.length())
+            len = trace_format (m.data, size, "%s: ", servername);
+          len += trace_format (m.data + len, size - len, "%c%08d: [%2d:%s] ", c, (msgid & 0xffffff), seq, name);
+          len += trace_format (m.data + len, size - len, msg, args...);
+          m.data[len++] = '\n';
+          AsyncLog::instance().commit(m, len);
+          return;
+        }
       if (servername.length())
         fmt::fprintf(stderr, "%s: ",servername.c_str());
       fmt::fprintf (stderr, "%c%08d: ", c, (msgid & 0xffffff));
@@ -217,8 +298,6 @@ public:
   }
 };
 
-typedef std::shared_ptr<Trace> TracePtr;
-
 
 #define TRACEPRINTF(trace, layer, msg, args...) do { if ((trace)->ShowPrint(layer)) (trace)->TracePrintf(layer, msg, ##args); } while (0)
 #define ERRORPRINTF(trace, msgid, msg, args...) do { \
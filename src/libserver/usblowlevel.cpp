@@ -23,6 +23,7 @@
 #include <ctype.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <algorithm>
 
 #include "usblowlevel.h"
 #include "usb.h"
@@ -150,13 +151,12 @@ detectUSBEndpoint (libusb_context *context, USBEndpoint e)
   return e2;
 }
 
-USBLowLevelDriver::USBLowLevelDriver (LowLevelIface* p, IniSectionPtr& s) : LowLevelDriver(p,s)
+USBLowLevelDriver::USBLowLevelDriver (LowLevelIface* p, IniSectionPtr& s)
+  : LowLevelDriver(p,s), completed(USB_COMPLETE_QUEUE)
 {
   t->setAuxName("usbL");
-  read_trigger.set<USBLowLevelDriver,&USBLowLevelDriver::read_trigger_cb>(this);
-  write_trigger.set<USBLowLevelDriver,&USBLowLevelDriver::write_trigger_cb>(this);
-  read_trigger.start();
-  write_trigger.start();
+  complete_trigger.set<USBLowLevelDriver,&USBLowLevelDriver::complete_trigger_cb>(this);
+  complete_trigger.start();
   reset();
 }
 
@@ -209,13 +209,20 @@ USBLowLevelDriver::start()
 
   TRACEPRINTF (t, 1, "Opened");
 
-  recvh = libusb_alloc_transfer (0);
-  if (!recvh)
+  overruns = 0;
+  recv_failed = false;
+  for (unsigned int i = 0; i < recv_transfers; i++)
     {
-      ERRORPRINTF (t, E_ERROR | 34, "Error AllocRecv: %s", strerror(errno));
-      goto ex;
-    } 
-  StartUsbRecvTransfer();
+      struct libusb_transfer *tr = AllocTransfer ();
+      if (!tr)
+        {
+          ERRORPRINTF (t, E_ERROR | 34, "Error AllocRecv: %s", strerror(errno));
+          goto ex;
+        }
+      recvh.push_back (tr);
+      if (!StartUsbRecvTransfer (tr))
+        goto ex;
+    }
   state = sRunning;
   started();
   return;
@@ -223,22 +230,44 @@ ex:
   stop();
 }
 
+struct libusb_transfer *
+USBLowLevelDriver::AllocTransfer ()
+{
+  struct libusb_transfer *tr = libusb_alloc_transfer (0);
+  if (!tr)
+    return nullptr;
+  tr->buffer = new uint8_t[USB_REPORT_SIZE];
+  return tr;
+}
+
+void
+USBLowLevelDriver::FreeTransfer (Array<struct libusb_transfer *> &list, struct libusb_transfer *tr)
+{
+  auto i = std::find (list.begin(), list.end(), tr);
+  if (i != list.end())
+    list.erase (i);
+  delete[] tr->buffer;
+  tr->buffer = nullptr;
+  libusb_free_transfer (tr);
+}
+
 void
 USBLowLevelDriver::abort_send()
 {
   int res;
-  if (sendh == nullptr)
+  if (sendh.empty())
     return;
 
-  if ((res = libusb_cancel_transfer (sendh)) < 0)
-    {
-      ERRORPRINTF (t, E_ERROR | 31, "cancel %lx: %s", (unsigned long) sendh, libusb_error_name(res));
-      sendh = nullptr; // XXX does this make sense?
-      out.clear();
-      return;
-    }
-  while (sendh)
-    ev_run(EV_DEFAULT_ EVRUN_ONCE);
+  ITER(i,sendh)
+    if ((res = libusb_cancel_transfer (*i)) < 0)
+      {
+        ERRORPRINTF (t, E_ERROR | 31, "cancel %lx: %s", (unsigned long) *i, libusb_error_name(res));
+        sendq.clear();
+        return;
+      }
+  while (!sendh.empty())
+    ev_run(::loop, EVRUN_ONCE);
+  sendq.clear();
 }
 
 void
@@ -249,14 +278,20 @@ USBLowLevelDriver::stop_()
 
   if (state > sClaimed)
     state = sClaimed;
-  if (sendh)
-    libusb_cancel_transfer (sendh);
-  if (recvh)
-    libusb_cancel_transfer (recvh);
+  ITER(i,sendh)
+    libusb_cancel_transfer (*i);
+  ITER(i,recvh)
+    libusb_cancel_transfer (*i);
   if (state > sClaimed)
     state = sClaimed;
-  while (sendh || recvh)
-    ev_run(EV_DEFAULT_ EVRUN_ONCE);
+  while (!sendh.empty() || recv_active)
+    ev_run(::loop, EVRUN_ONCE);
+  while (!recvh.empty())
+    FreeTransfer (recvh, recvh.front());
+  sendq.clear();
+  unsigned long lost = overruns.exchange (0);
+  if (lost)
+    ERRORPRINTF (t, E_WARNING | 71, "%lu receive overruns: all receive transfers were busy. Consider raising recv-transfers.", lost);
 
   TRACEPRINTF (t, 1, "Release");
   if (state > sStarted)
@@ -281,134 +316,148 @@ USBLowLevelDriver::stop()
 USBLowLevelDriver::~USBLowLevelDriver ()
 {
   stop();
-  read_trigger.stop();
-  write_trigger.stop();
+  complete_trigger.stop();
 }
 
 void
 USBLowLevelDriver::send_Data (CArray& l)
 {
-  if (sendh != nullptr)
+  if (sendq.size() + sendh.size() >= send_transfers)
     {
       ERRORPRINTF (t, E_FATAL | 35, "Send while buffer not empty");
       errored(); // XXX signal async
       return;
     }
-  out = l;
+  sendq.push (l);
   do_send();
 }
 
+/* runs in libusb's event thread */
 void
-usb_complete_send (struct libusb_transfer *transfer)
+usb_complete (struct libusb_transfer *transfer)
 {
   USBLowLevelDriver *
     instance = (USBLowLevelDriver *) transfer->user_data;
-  instance->CompleteSend(transfer);
+  instance->Complete(transfer);
 }
 
+/* runs in libusb's event thread */
 void
-USBLowLevelDriver::CompleteSend(struct libusb_transfer *transfer)
+USBLowLevelDriver::Complete(struct libusb_transfer *transfer)
 {
-  if (transfer != sendh)
-    ERRORPRINTF (t, E_WARNING | 35, "SendComp %lx %lx",(unsigned long)transfer,(unsigned long)sendh);
-  assert(transfer == sendh);
+  /* If no other transfer was waiting, the device had nowhere to put
+   * reports until we resubmit. Check this here: the main loop may
+   * take a while to get to the transfer. */
+  if (transfer->endpoint != d.sendep && --recv_pending == 0
+      && transfer->status == LIBUSB_TRANSFER_COMPLETED && recv_transfers > 1)
+    {
+      unsigned long n = ++overruns;
+      TRACEPRINTF (t, 0, "Receive overrun, %lu so far", n);
+    }
 
-  TRACEPRINTF (t, 10, "SendCB %lx", (unsigned long) sendh);
-  write_trigger.send();
+  /* can't overflow: there are fewer transfers than slots */
+  bool ok = completed.push (std::move(transfer));
+  assert (ok);
+  (void)ok;
+  complete_trigger.send();
 }
 
 void
-USBLowLevelDriver::write_trigger_cb(ev::async &w UNUSED, int revents UNUSED)
+USBLowLevelDriver::complete_trigger_cb(ev::async &w UNUSED, int revents UNUSED)
 {
-  TRACEPRINTF (t, 10, "SendComplete %lx %d", (unsigned long)sendh, sendh->actual_length);
-  if (sendh == nullptr)
-    return;
-  if (sendh->status == LIBUSB_TRANSFER_COMPLETED)
-    {
-      libusb_free_transfer (sendh);
-      send_retry = 0;
-      sendh = nullptr;
-      send_Next();
-      return;
-    }
-  if (sendh->status == LIBUSB_TRANSFER_TIMED_OUT && ++send_retry < 3)
+  struct libusb_transfer *transfer;
+  while (completed.pop (transfer))
     {
-      ERRORPRINTF (t, E_WARNING | 35, "SendError %lx timeout, retrying", (unsigned long)sendh);
-      libusb_free_transfer (sendh);
-      sendh = nullptr;
-      do_send();
-      return;
+      if (transfer->endpoint == d.sendep)
+        CompleteSend(transfer);
+      else
+        CompleteReceive(transfer);
     }
-  ERRORPRINTF (t, E_ERROR | 35, "SendError %lx status %d", (unsigned long)sendh, sendh->status);
-  sendh = nullptr;
-  errored(); // TODO probably needs to be an async error
-  return;
-}
-
-void
-USBLowLevelDriver::do_send_Next()
-{
-  out.clear();
-  LowLevelDriver::do_send_Next();
 }
 
 void
-usb_complete_recv (struct libusb_transfer *transfer)
+USBLowLevelDriver::CompleteSend(struct libusb_transfer *sendh1)
 {
-  USBLowLevelDriver *
-    instance = (USBLowLevelDriver *) transfer->user_data;
-  instance->CompleteReceive(transfer);
-}
-
-void 
-USBLowLevelDriver::CompleteReceive(struct libusb_transfer *transfer)
-{
-  assert (transfer == recvh);
-  TRACEPRINTF (t, 10, "RecvCB %lx", (unsigned long) recvh);
-  read_trigger.send();
+  int status = sendh1->status;
+  TRACEPRINTF (t, 10, "SendComplete %lx %d", (unsigned long)sendh1, sendh1->actual_length);
+  if (status == LIBUSB_TRANSFER_COMPLETED)
+    {
+      FreeTransfer (sendh, sendh1);
+      send_retry = 0;
+      do_send();
+      if (send_blocked)
+        {
+          send_blocked = false;
+          send_Next();
+        }
+      return;
+    }
+  if (status == LIBUSB_TRANSFER_TIMED_OUT && ++send_retry < 3 && !stopping)
+    {
+      /* With more than one send transfer, this may reorder packets. */
+      ERRORPRINTF (t, E_WARNING | 35, "SendError %lx timeout, retrying", (unsigned long)sendh1);
+      int res = libusb_submit_transfer (sendh1);
+      if (!res)
+        return;
+      ERRORPRINTF (t, E_ERROR | 37, "Error StartSend: %s", libusb_error_name(res));
+    }
+  else if (status != LIBUSB_TRANSFER_CANCELLED)
+    ERRORPRINTF (t, E_ERROR | 35, "SendError %lx status %d", (unsigned long)sendh1, status);
+  FreeTransfer (sendh, sendh1);
+  if (!stopping && status != LIBUSB_TRANSFER_CANCELLED)
+    errored(); // TODO probably needs to be an async error
 }
 
 void
-USBLowLevelDriver::read_trigger_cb(ev::async &w UNUSED, int revents UNUSED)
+USBLowLevelDriver::CompleteReceive(struct libusb_transfer *recvh1)
 {
-  TRACEPRINTF (t, 10, "RecvComplete %lx %d", (unsigned long) recvh, recvh->actual_length);
-  if (recvh == nullptr)
-    return;
+  TRACEPRINTF (t, 10, "RecvComplete %lx %d", (unsigned long) recvh1, recvh1->actual_length);
+  recv_active--;
 
-  if (recvh->status != LIBUSB_TRANSFER_COMPLETED)
+  if (recvh1->status != LIBUSB_TRANSFER_COMPLETED)
     {
-      ERRORPRINTF (t, E_WARNING | 33, "RecvError %d", recvh->status);
-      recvh = nullptr;
+      if (recvh1->status == LIBUSB_TRANSFER_CANCELLED && stopping)
+        return;
+      if (recvh1->status == LIBUSB_TRANSFER_OVERFLOW)
+        overruns++;
+      /* the other transfers usually fail the same way */
+      if (recv_failed)
+        {
+          TRACEPRINTF (t, 0, "RecvError %d", recvh1->status);
+          return;
+        }
+      recv_failed = true;
+      ERRORPRINTF (t, E_WARNING | 33, "RecvError %d", recvh1->status);
       errored();
       return;
     }
-  else
-    HandleReceiveUsb();
+
+  HandleReceiveUsb(recvh1->buffer);
 
   if (state > sNone && !stopping)
-    StartUsbRecvTransfer();
-  else
-    {
-      libusb_free_transfer (recvh);
-      recvh = nullptr;
-    }
+    StartUsbRecvTransfer(recvh1);
 }
 
 
-void 
-USBLowLevelDriver::StartUsbRecvTransfer()
+bool
+USBLowLevelDriver::StartUsbRecvTransfer(struct libusb_transfer *recvh1)
 {
-  libusb_fill_interrupt_transfer (recvh, dev, d.recvep, recvbuf,
-                                  sizeof (recvbuf), usb_complete_recv,
+  libusb_fill_interrupt_transfer (recvh1, dev, d.recvep, recvh1->buffer,
+                                  USB_REPORT_SIZE, usb_complete,
                                   this, 0);
-  int res = libusb_submit_transfer (recvh);
+  /* before submitting, the transfer may complete right away */
+  recv_pending++;
+  int res = libusb_submit_transfer (recvh1);
   if (res)
     {
+      recv_pending--;
       ERRORPRINTF (t, E_ERROR | 32, "Error StartRecv: %s", libusb_error_name(res));
       errored();
-      return;
+      return false;
     }
+  recv_active++;
   TRACEPRINTF (t, 10, "StartRecv");
+  return true;
 }
 
 inline bool is_connection_state(uint8_t *recvbuf)
@@ -423,10 +472,10 @@ bool get_connection_state(uint8_t *recvbuf)
 }
 
 void 
-USBLowLevelDriver::HandleReceiveUsb()
+USBLowLevelDriver::HandleReceiveUsb(uint8_t *recvbuf)
 {
   CArray res;
-  res.set (recvbuf, sizeof (recvbuf));
+  res.set (recvbuf, USB_REPORT_SIZE);
   t->TracePacket (0, "RecvUSB", res);
   master->recv_Data (res);
 
@@ -459,34 +508,54 @@ USBLowLevelDriver::HandleReceiveUsb()
 void
 USBLowLevelDriver::do_send()
 {
-  if (sendh || state < sClaimed || !out.size())
-    return;
-
-  t->TracePacket (0, "SendUSB", out);
-  memset (sendbuf, 0, sizeof (sendbuf));
-  memcpy (sendbuf, out.data(),
-          (out.size() > sizeof (sendbuf) ? sizeof (sendbuf) : out.size()));
-  sendh = libusb_alloc_transfer (0);
-  if (!sendh)
+  while (sendh.size() < send_transfers && !sendq.isempty() && state >= sClaimed)
     {
-      ERRORPRINTF (t, E_ERROR | 36, "Error AllocSend: %s", strerror(errno));
-      return;
-    }
-  libusb_fill_interrupt_transfer (sendh, dev, d.sendep, sendbuf,
-                                  sizeof (sendbuf), usb_complete_send,
-                                  this, 1000);
-  int res = libusb_submit_transfer (sendh);
-  if (res)
-    {
-      ERRORPRINTF (t, E_ERROR | 37, "Error StartSend: %s", libusb_error_name(res));
-      return;
+      CArray out = sendq.get();
+      t->TracePacket (0, "SendUSB", out);
+      struct libusb_transfer *sendh1 = AllocTransfer ();
+      if (!sendh1)
+        {
+          ERRORPRINTF (t, E_ERROR | 36, "Error AllocSend: %s", strerror(errno));
+          return;
+        }
+      memset (sendh1->buffer, 0, USB_REPORT_SIZE);
+      memcpy (sendh1->buffer, out.data(),
+              (out.size() > USB_REPORT_SIZE ? USB_REPORT_SIZE : out.size()));
+      libusb_fill_interrupt_transfer (sendh1, dev, d.sendep, sendh1->buffer,
+                                      USB_REPORT_SIZE, usb_complete,
+                                      this, 1000);
+      int res = libusb_submit_transfer (sendh1);
+      if (res)
+        {
+          ERRORPRINTF (t, E_ERROR | 37, "Error StartSend: %s", libusb_error_name(res));
+          FreeTransfer (sendh, sendh1);
+          return;
+        }
+      sendh.push_back (sendh1);
+      TRACEPRINTF (t, 0, "StartSend %lx", (unsigned long)sendh1);
+
+      /* Let the next packet come in while this one is in flight,
+       * if there's room for it. */
+      if (sendh.size() + sendq.size() < send_transfers)
+        send_Next();
+      else
+        send_blocked = true;
     }
-  TRACEPRINTF (t, 0, "StartSend %lx", (unsigned long)sendh);
 }
 
 bool
 USBLowLevelDriver::setup()
 {
+  int nr = cfg->value("recv-transfers", 4);
+  int ns = cfg->value("send-transfers", 1);
+  if (nr < 1 || nr > USB_MAX_TRANSFERS || ns < 1 || ns > USB_MAX_TRANSFERS)
+    {
+      ERRORPRINTF (t, E_ERROR | 71, "recv-transfers and send-transfers must be between 1 and %d", USB_MAX_TRANSFERS);
+      return false;
+    }
+  recv_transfers = nr;
+  send_transfers = ns;
+
   loop = new USBLoop (t);
 
   if (!loop->context)
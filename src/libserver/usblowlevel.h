@@ -20,9 +20,18 @@
 #ifndef EIB_USB_H
 #define EIB_USB_H
 
+#include <atomic>
 #include <libusb.h>
 #include "lowlevel.h"
 #include "usb.h"
+#include "spscqueue.h"
+
+/** size of a HID report */
+#define USB_REPORT_SIZE 64
+/** limit for recv-transfers and send-transfers */
+#define USB_MAX_TRANSFERS 8
+/** room for finished transfers on their way to the main loop */
+#define USB_COMPLETE_QUEUE (2*USB_MAX_TRANSFERS)
 
 typedef struct
 {
@@ -65,30 +74,49 @@ private:
   USBLoop *loop;
   USBDevice d;
 
-  /** transmit buffer */
-  CArray out;
+  /** packets waiting for a send transfer */
+  Queue<CArray> sendq;
   /** transmit retry counter */
   int send_retry = 0;
+  /** send_Next() is owed once a send transfer completes */
+  bool send_blocked = false;
 
   UState state = sNone;
   bool stopping = false;
-  uint8_t sendbuf[64];
-  uint8_t recvbuf[64];
-  bool startUsbRecvTransferFailed = false;
-
-  struct libusb_transfer *sendh = 0;
-  struct libusb_transfer *recvh = 0;
 
-  void StartUsbRecvTransfer();
-  void HandleReceiveUsb();
+  /** How many receive transfers to keep submitted. With more than one,
+   * the device can deliver its next report while we handle the last. */
+  unsigned int recv_transfers;
+  /** how many packets may be in flight to the device */
+  unsigned int send_transfers;
+  /** all receive transfers */
+  Array<struct libusb_transfer *> recvh;
+  /** receive transfers which are submitted */
+  int recv_active = 0;
+  /** receive transfers which libusb hasn't finished. Unlike recv_active,
+   * this is updated in libusb's thread, before the main loop gets to the
+   * completed transfer. */
+  std::atomic<int> recv_pending {0};
+  /** send transfers which are submitted */
+  Array<struct libusb_transfer *> sendh;
+  /** times we had no receive transfer submitted */
+  std::atomic<unsigned long> overruns {0};
+  /** a failed receive transfer has been reported */
+  bool recv_failed = false;
+
+  struct libusb_transfer *AllocTransfer();
+  void FreeTransfer(Array<struct libusb_transfer *> &list, struct libusb_transfer *tr);
+  bool StartUsbRecvTransfer(struct libusb_transfer *tr);
+  void HandleReceiveUsb(uint8_t *recvbuf);
   virtual void reset();
   void do_send();
-  void do_send_Next();
   void stop_();
 
-  // need to do the trigger callbacks outside of libusb
-  ev::async read_trigger; void read_trigger_cb(ev::async &w, int revents);
-  ev::async write_trigger; void write_trigger_cb(ev::async &w, int revents);
+  /** transfers finished by libusb's event thread */
+  SPSCQueue<struct libusb_transfer *> completed;
+  ev::async complete_trigger {::loop}; void complete_trigger_cb(ev::async &w, int revents);
+  void CompleteReceive(struct libusb_transfer *tr);
+  void CompleteSend(struct libusb_transfer *tr);
 
 public:
   bool setup();
@@ -98,9 +126,8 @@ public:
   void abort_send();
 
 
-  // for use by callbacks only
-  void CompleteReceive(struct libusb_transfer *recvh);
-  void CompleteSend(struct libusb_transfer *recvh);
+  // for use by callbacks only, in libusb's thread
+  void Complete(struct libusb_transfer *transfer);
 };
 
 #endif
@@ -26,10 +26,16 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <pthread.h>
 #include <ev++.h>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
 #include "router.h"
 #include "version.h"
 #include "link.h"
+#include "bridge.h"
 
 #ifdef HAVE_SYSTEMD
 #include <systemd/sd-daemon.h>
@@ -46,8 +52,6 @@ const char *cfgfile = NULL;
 const char *mainsection = NULL;
 char *const *argv;
 
-LOOP_RESULT loop;
-
 void usage()
 {
   fprintf(stderr,"Usage: knxd configfile [main_section]\n");
@@ -205,6 +209,207 @@ signal_cb (EV_P_ ev_signal *w UNUSED, int revents UNUSED)
   stopping = true;
 }
 
+/** A routing domain, with its own Router and event loop in a thread */
+struct Domain
+{
+  std::string name;
+  struct ev_loop *loop;
+  std::thread thread;
+  /** sent by the main thread */
+  ev_async stop;
+  ev_async dump;
+  Router *r = nullptr;
+  /** how often the main thread has sent "stop" */
+  std::atomic<int> stops {0};
+  /** the router has terminated on its own */
+  std::atomic<bool> ended {false};
+  int exitcode = 0;
+  /** whether setup() worked */
+  std::promise<bool> ready;
+};
+static std::vector<Domain *> domains;
+/** tells the domains whether to start, once the main router is set up */
+static std::promise<bool> go;
+/** sent by a domain whose router has terminated on its own */
+static ev_async domain_end;
+
+static void
+domain_end_cb (EV_P_ ev_async *w, int revents UNUSED)
+{
+  Router *r = static_cast<Router *>(w->data);
+  for (auto d : domains)
+    if (d->ended)
+      ERRORPRINTF (r->t, E_ERROR | 70, "Domain %s terminated", d->name);
+  r->exitcode = 1;
+  ev_break (EV_A_ EVBREAK_ALL);
+  stopping = true;
+}
+
+static void
+domain_stop_cb (EV_P_ ev_async *w UNUSED, int revents UNUSED)
+{
+  ev_break (EV_A_ EVBREAK_ALL);
+}
+
+static void
+domain_dump_cb (EV_P_ ev_async *w, int revents UNUSED)
+{
+  Domain *d = static_cast<Domain *>(w->data);
+  if (d->r != nullptr)
+    d->r->dump_recorders("SIGUSR1");
+}
+
+static void
+sigusr1_cb (EV_P_ ev_signal *w, int revents UNUSED)
+{
+  static_cast<Router *>(w->data)->dump_recorders("SIGUSR1");
+  for (auto d : domains)
+    ev_async_send (d->loop, &d->dump);
+}
+
+/** Add a bridge link, using this pipe, to a domain's connections. */
+static void
+add_bridge (IniData &i, const std::string &domain, const std::string &link,
+            const std::string &pipe, int side)
+{
+  i.read_only = false;
+  IniSectionPtr s = i[link];
+  (*s)["driver"] = "bridge";
+  (*s)["bridge"] = pipe;
+  (*s)["side"] = std::to_string(side);
+
+  std::string &c = (*i[domain])["connections"];
+  c = c.empty() ? link : c + "," + link;
+  i.read_only = true;
+}
+
+static void
+run_domain (IniData *i, Domain *d, std::shared_future<bool> start)
+{
+  /* signals are the main thread's business */
+  sigset_t all;
+  sigfillset (&all);
+  pthread_sigmask (SIG_BLOCK, &all, NULL);
+  loop = d->loop;
+
+  Router *r = new Router(*i, d->name);
+  r->check_unseen = false;
+  bool ok = r->setup();
+  if (!ok)
+    ERRORPRINTF (r->t, E_FATAL, "Error setting up routing domain %s.", d->name);
+  d->r = r;
+  d->ready.set_value (ok);
+
+  if (ok && start.get() && !stop_now)
+    {
+      r->start();
+      ev_run (loop, 0);
+      if (!d->stops)
+        {
+          d->ended = true;
+          ev_async_send (EV_DEFAULT_ &domain_end);
+        }
+    }
+
+  r->stop();
+  while (!r->isIdle() && d->stops < 2)
+    ev_run (loop, EVRUN_ONCE);
+  d->exitcode = ok ? r->exitcode : 2;
+  d->r = nullptr;
+  delete r;
+}
+
+/** Start a thread for each routing domain.
+ *
+ * Every domain gets its own Router and event loop, thus its own CPU.
+ * Each one is connected to the main domain by a "bridge" link. In the
+ * main domain that link's section is "DOMAIN-bridge"; in the other
+ * domain it's "DOMAIN-uplink". Filters for these links go there.
+ *
+ * The domains are set up one after the other, before the main router;
+ * they start running when go is set.
+ *
+ * Returns false if a domain couldn't be set up.
+ */
+static bool
+start_domains (IniData &i)
+{
+  std::string x = i[mainsection]->value("domains","");
+  std::vector<std::string> names;
+  size_t pos = 0;
+  size_t comma = 0;
+  while(true)
+    {
+      comma = x.find(',',pos);
+      std::string name = x.substr(pos,comma-pos);
+      if (name.size())
+        names.push_back(name);
+      if (comma == std::string::npos)
+        break;
+      pos = comma+1;
+    }
+
+  std::shared_future<bool> start = go.get_future().share();
+  for (auto &name : names)
+    {
+      Domain *d = new Domain;
+      d->name = name;
+      d->loop = ev_loop_new (EVFLAG_AUTO);
+      if (d->loop == nullptr)
+        die ("event loop for domain %s", name.c_str());
+      ev_async_init (&d->stop, domain_stop_cb);
+      ev_async_start (d->loop, &d->stop);
+      ev_async_init (&d->dump, domain_dump_cb);
+      d->dump.data = d;
+      ev_async_start (d->loop, &d->dump);
+      domains.push_back (d);
+
+      BridgePipe::create (name, loop, d->loop);
+      add_bridge (i, mainsection, name + "-bridge", name, 0);
+      add_bridge (i, name, name + "-uplink", name, 1);
+
+      std::future<bool> ready = d->ready.get_future();
+      d->thread = std::thread (run_domain, &i, d, start);
+      if (!ready.get())
+        return false;
+    }
+  return true;
+}
+
+/** Stop the domains' routers and wait for their threads.
+ * Returns the first non-zero exit code. */
+static int
+stop_domains ()
+{
+  int exitcode = 0;
+  for (auto d : domains)
+    {
+      d->stops++;
+      ev_async_send (d->loop, &d->stop);
+    }
+  for (auto d : domains)
+    {
+      /* a second signal aborts the shutdown */
+      if (stopping)
+        {
+          d->stops++;
+          ev_async_send (d->loop, &d->stop);
+        }
+      if (d->thread.joinable())
+        d->thread.join();
+      if (!exitcode)
+        exitcode = d->exitcode;
+    }
+  BridgePipe::clear();
+  for (auto d : domains)
+    {
+      ev_loop_destroy (d->loop);
+      delete d;
+    }
+  domains.clear();
+  return exitcode;
+}
+
 #ifdef EV_TRACE
 static void
 timeout_cb (EV_P_ ev_timer *w, int revents)
@@ -257,6 +462,7 @@ main (int ac, char *ag[])
   struct _hup hup;
   struct ev_signal sigint;
   struct ev_signal sigterm;
+  struct ev_signal sigusr1;
 
 #ifdef EV_TRACE
   printf("LIBEV starting up\n");
@@ -333,8 +539,11 @@ main (int ac, char *ag[])
     die("Parse error of '%s' in line %d", cfgfile, errl);
   IniSectionPtr main = i[mainsection];
 
-  pidfile = using_systemd ? NULL : main->value("pidfile","").c_str();
-  logfile = using_systemd ? NULL : main->value("logfile","").c_str();
+  // value() returns a temporary here, so keep these alive
+  std::string pidfile_s = main->value("pidfile","");
+  std::string logfile_s = main->value("logfile","");
+  pidfile = using_systemd ? NULL : pidfile_s.c_str();
+  logfile = using_systemd ? NULL : logfile_s.c_str();
   background = using_systemd ? false : main->value("background",false);
 
   if (!stop_now)
@@ -370,6 +579,13 @@ main (int ac, char *ag[])
       setsid ();
     }
 
+  if (!start_domains (i))
+    {
+      go.set_value (false);
+      stop_domains ();
+      exit(2);
+    }
+
   Router *r = new Router(i,mainsection);
 
   ERRORPRINTF (r->t, E_INFO | 0, "%s:%s", REAL_VERSION, arg_str);
@@ -377,6 +593,8 @@ main (int ac, char *ag[])
   if (!r->setup())
     {
       ERRORPRINTF(r->t, E_FATAL,"Error setting up the KNX router.");
+      go.set_value (false);
+      stop_domains ();
       exit(2);
     }
   if (!strcmp(cfgfile, "-"))
@@ -403,7 +621,14 @@ main (int ac, char *ag[])
       ev_signal_start (EV_A_ &sigint);
       ev_signal_init (&sigterm, signal_cb, SIGTERM);
       ev_signal_start (EV_A_ &sigterm);
+      ev_signal_init (&sigusr1, sigusr1_cb, SIGUSR1);
+      sigusr1.data = r;
+      ev_signal_start (EV_A_ &sigusr1);
     }
+  ev_async_init (&domain_end, domain_end_cb);
+  domain_end.data = r;
+  ev_async_start (EV_A_ &domain_end);
+  go.set_value (true);
 
   FILE *pidf;
   if (pidfile && *pidfile)
@@ -433,6 +658,9 @@ main (int ac, char *ag[])
 
   int exitcode = r->exitcode;
   delete r;
+  int dexit = stop_domains ();
+  if (!exitcode)
+    exitcode = dexit;
 
   if (pidfile && *pidfile)
     unlink (pidfile);
@@ -0,0 +1,311 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+/** Render a knxd binary trace file (see bintrace.h) as text */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#include "bintrace.h"
+
+struct Arg
+{
+  char tag;
+  uint64_t num;
+  double dbl;
+  std::string str;
+};
+
+static std::vector<uint8_t> file;
+static const BinTraceHeader *hdr;
+
+static void __attribute__ ((format (printf, 2, 3)))
+appendf (std::string& out, const char *spec, ...)
+{
+  va_list ap;
+  char buf[256];
+  va_start (ap, spec);
+  int n = vsnprintf (buf, sizeof(buf), spec, ap);
+  va_end (ap);
+  if (n < (int) sizeof(buf))
+    {
+      out += buf;
+      return;
+    }
+  std::vector<char> big (n + 1);
+  va_start (ap, spec);
+  vsnprintf (big.data(), big.size(), spec, ap);
+  va_end (ap);
+  out += big.data();
+}
+
+/** Render one printf-style conversion.
+ * Like fmt::sprintf, which knxd uses, this goes by the argument's type;
+ * the conversion character only selects the representation. */
+static void
+render (std::string& out, std::string flags, char conv, const Arg *a)
+{
+  if (a == nullptr)
+    {
+      out += "<?>";
+      return;
+    }
+  std::string spec = "%" + flags;
+  switch (a->tag)
+    {
+    case 's':
+      appendf (out, (spec + "s").c_str(), a->str.c_str());
+      break;
+    case 'd':
+      if (!strchr ("eEfFgGaA", conv))
+        conv = 'g';
+      appendf (out, (spec + conv).c_str(), a->dbl);
+      break;
+    case 'p':
+      appendf (out, (spec + "p").c_str(), (void *)(uintptr_t) a->num);
+      break;
+    case 'i':
+    case 'u':
+      if (conv == 'c')
+        appendf (out, (spec + "c").c_str(), (int) a->num);
+      else if (strchr ("eEfFgGaA", conv))
+        appendf (out, (spec + conv).c_str(),
+                 a->tag == 'i' ? (double)(int64_t) a->num : (double) a->num);
+      else if (strchr ("xXo", conv))
+        appendf (out, (spec + "ll" + conv).c_str(), (unsigned long long) a->num);
+      else if (a->tag == 'i')
+        appendf (out, (spec + "lld").c_str(), (long long)(int64_t) a->num);
+      else
+        appendf (out, (spec + "llu").c_str(), (unsigned long long) a->num);
+      break;
+    default:
+      out += "<?>";
+    }
+}
+
+static std::string
+format (const char *fmt, const std::vector<Arg>& args, size_t ai)
+{
+  std::string out;
+  for (const char *p = fmt; *p; p++)
+    {
+      if (*p != '%')
+        {
+          out += *p;
+          continue;
+        }
+      if (p[1] == '%')
+        {
+          out += '%';
+          p++;
+          continue;
+        }
+      std::string flags;
+      p++;
+      while (*p && strchr ("-+ #0", *p))
+        flags += *p++;
+      for (int prec = 0; prec < 2; prec++)
+        {
+          if (prec)
+            {
+              if (*p != '.')
+                break;
+              flags += *p++;
+            }
+          if (*p == '*')
+            {
+              p++;
+              if (ai < args.size())
+                flags += std::to_string ((int64_t) args[ai++].num);
+            }
+          else
+            while (*p >= '0' && *p <= '9')
+              flags += *p++;
+        }
+      while (*p && strchr ("hlLqjzt", *p))
+        p++;
+      if (!*p)
+        break;
+      render (out, flags, *p, ai < args.size() ? &args[ai++] : nullptr);
+    }
+  return out;
+}
+
+static std::string
+timestamp (uint64_t ns)
+{
+  time_t sec = ns / 1000000000;
+  struct tm tm;
+  char buf[64];
+  localtime_r (&sec, &tm);
+  size_t n = strftime (buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+  snprintf (buf + n, sizeof(buf) - n, ".%06u", (unsigned) (ns % 1000000000 / 1000));
+  return buf;
+}
+
+static char
+level_char (int level)
+{
+  static const char levels[] = "XFCEWNIDT";
+  return level < 9 ? levels[level] : '?';
+}
+
+/** print one record; returns false if it's garbage */
+static bool
+print_record (const uint8_t *p)
+{
+  const BinTraceRecord *r = (const BinTraceRecord *) p;
+  if (r->len < sizeof(BinTraceRecord) || r->len > BT_MAXREC)
+    return false;
+
+  /* decode the arguments */
+  std::vector<Arg> args;
+  const uint8_t *a = p + sizeof(BinTraceRecord);
+  const uint8_t *end = p + r->len;
+  while (a < end && *a && strchr ("iupdsb", *a))
+    {
+      Arg x;
+      x.tag = *a++;
+      if (x.tag == 's' || x.tag == 'b')
+        {
+          uint16_t l;
+          if (a + 2 > end)
+            break;
+          memcpy (&l, a, 2);
+          if (a + 2 + l > end)
+            break;
+          x.str.assign ((const char *) a + 2, l);
+          a += 2 + l;
+        }
+      else
+        {
+          if (a + 8 > end)
+            break;
+          memcpy (&x.num, a, 8);
+          memcpy (&x.dbl, a, 8);
+          a += 8;
+        }
+      args.push_back (x);
+    }
+  if (args.empty())
+    return false;
+
+  const std::string& name = args[0].str;
+  size_t ai = 1;
+  std::string fmt;
+  if (r->fmt == BT_NOFMT)
+    {
+      if (args.size() < 2)
+        return false;
+      fmt = args[1].str;
+      ai = 2;
+    }
+  else if (r->fmt + 2 < hdr->strtab_used)
+    fmt = (const char *) &file[hdr->hdr_size + r->fmt + 2];
+  else
+    fmt = "<unknown format>";
+
+  std::string ts = timestamp (r->time);
+  switch (r->type)
+    {
+    case BT_TRACE:
+      printf ("Layer %d [%2u:%s %s] %s\n", r->layer, r->seq, name.c_str(),
+              ts.c_str(), format (fmt.c_str(), args, ai).c_str());
+      break;
+    case BT_ERROR:
+      printf ("%c%08u: [%2u:%s %s] %s\n", level_char (r->layer), r->msgid,
+              r->seq, name.c_str(), ts.c_str(),
+              format (fmt.c_str(), args, ai).c_str());
+      break;
+    case BT_PACKET:
+      {
+        std::string data = ai < args.size() ? args[ai].str : "";
+        printf ("Layer %d [%2u:%s %s] %s(%03d):", r->layer, r->seq,
+                name.c_str(), ts.c_str(), fmt.c_str(), (int) data.size());
+        for (unsigned int i = 0; i < data.size(); i++)
+          printf (" %02X", (uint8_t) data[i]);
+        printf ("\n");
+      }
+      break;
+    default:
+      return false;
+    }
+  return true;
+}
+
+int
+main (int ac, char *ag[])
+{
+  if (ac != 2)
+    {
+      fprintf (stderr, "Usage: %s tracefile\n", ag[0]);
+      return 1;
+    }
+  FILE *f = fopen (ag[1], "rb");
+  if (!f)
+    {
+      perror (ag[1]);
+      return 1;
+    }
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread (buf, 1, sizeof(buf), f)) > 0)
+    file.insert (file.end(), buf, buf + n);
+  fclose (f);
+
+  hdr = (const BinTraceHeader *) file.data();
+  if (file.size() < sizeof(*hdr)
+      || memcmp (hdr->magic, BINTRACE_MAGIC, sizeof(hdr->magic))
+      || hdr->version != BINTRACE_VERSION
+      || file.size() < hdr->hdr_size + hdr->strtab_size + hdr->ring_size
+      || hdr->strtab_used > hdr->strtab_size)
+    {
+      fprintf (stderr, "%s: not a knxd trace file\n", ag[1]);
+      return 1;
+    }
+
+  const uint8_t *ring = &file[hdr->hdr_size + hdr->strtab_size];
+  uint64_t size = hdr->ring_size;
+  for (uint64_t pos = hdr->tail; pos < hdr->head; )
+    {
+      const uint8_t *p = ring + pos % size;
+      const BinTraceRecord *r = (const BinTraceRecord *) p;
+      /* Records are 8-byte aligned, so len and type are always there.
+       * The pad at the end of the ring may be shorter than a header. */
+      if (r->type == BT_PAD && r->len >= 8 && pos % size + r->len == size)
+        {
+          pos += r->len;
+          continue;
+        }
+      if (pos % size + sizeof(*r) > size || pos % size + r->len > size
+          || !print_record (p))
+        {
+          fprintf (stderr, "%s: corrupted record at %llu\n", ag[1],
+                   (unsigned long long) pos);
+          return 1;
+        }
+      pos += r->len;
+    }
+  return 0;
+}
@@ -0,0 +1,412 @@
+/*
+    EIBD eib bus access and management daemon
+    Copyright (C) 2005-2011 Martin Koegler <mkoegler@auto.tuwien.ac.at>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+
+/* Microbenchmark for the PDU codecs.
+ *
+ * Runs every codec over a mix of L_Data frames and reports the time and
+ * the number of heap allocations per operation. Run it before and after
+ * touching the codecs.
+ *
+ * Then it connects a number of clients to a knxd_unix server and reports
+ * how much heap each of them costs, both idle and with a group socket.
+ *
+ * The built-in mix is weighted to resemble the traffic of a typical
+ * installation. Alternatively, pass a capture file: one TP1 frame per
+ * line as hex bytes ("bc 11 0a 0a 03 e1 00 81 ce"), including the
+ * checksum; text up to a colon (as in knxd's trace output) and lines
+ * starting with '#' are ignored.
+ *
+ * usage: pdubench [-n iterations] [-c clients] [capture]
+ */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "apdu.h"
+#include "dummy.h"
+#include "eibnetip.h"
+#include "emi.h"
+#include "inifile.h"
+#include "localserver.h"
+#include "lpdu.h"
+#include "tpdu.h"
+#include "client.h"
+
+/* Count heap allocations. Pooled frames don't show up here unless their
+ * pool runs dry, which is the point. */
+static unsigned long allocs;
+/* bytes currently allocated */
+static long live;
+
+void *
+operator new (size_t n)
+{
+  allocs++;
+  void *p = malloc (n ? n : 1);
+  if (!p)
+    throw std::bad_alloc ();
+  live += malloc_usable_size (p);
+  return p;
+}
+
+void *
+operator new[] (size_t n)
+{
+  return operator new (n);
+}
+
+void
+operator delete (void *p) noexcept
+{
+  if (p)
+    live -= malloc_usable_size (p);
+  free (p);
+}
+
+void operator delete[] (void *p) noexcept { operator delete (p); }
+void operator delete (void *p, size_t) noexcept { operator delete (p); }
+void operator delete[] (void *p, size_t) noexcept { operator delete (p); }
+
+/** one frame of the mix, in every encoding the codecs deal with */
+struct Sample
+{
+  LDataPtr l;
+  /** TP1 frame */
+  CArray raw;
+  CArray cemi, emi1, emi2;
+  /** cEMI in a routing indication */
+  EIBNetIPPacket ip;
+  CArray ipraw;
+};
+
+struct Result
+{
+  double ns;
+  double allocs;
+};
+
+static double
+now ()
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/** run f on the samples in turn, iter times in total */
+template<class F>
+static Result
+bench (const Array<const Sample *> &order, unsigned long iter, F f)
+{
+  Result r;
+  unsigned long a = allocs;
+  double start = now ();
+  for (unsigned long i = 0; i < iter; i++)
+    f (*order[i % order.size()]);
+  r.ns = (now () - start) * 1e9 / iter;
+  r.allocs = (double) (allocs - a) / iter;
+  return r;
+}
+
+static void
+report (const char *what, Result r)
+{
+  printf ("%-28s %8.1f ns/op %6.2f allocs/op\n", what, r.ns, r.allocs);
+}
+
+/** heap use per client connection */
+static void
+report_clients (const char *what, unsigned int n, long bytes, unsigned long a)
+{
+  printf ("%-28s %8.0f bytes/conn %6.2f allocs/conn\n", what,
+          (double) bytes / n, (double) a / n);
+}
+
+/** Connect n clients to a knxd_unix server, then open a group socket
+ * on each of them. The router isn't started, as that would need real
+ * connections; the clients don't notice. The server checks its filter
+ * stack with a dummy driver, hence dummy.h. */
+static bool
+bench_clients (unsigned int n)
+{
+  loop = ev_default_loop (EVFLAG_AUTO);
+
+  IniData ini;
+  IniSectionPtr& m = ini["main"];
+  (*m)["addr"] = "0.0.1";
+  (*m)["client-addrs"] = fmt::sprintf ("1.0.1:%u", n);
+  (*m)["connections"] = "a,b";
+  (*ini["a"])["server"] = "knxd_unix";
+  (*ini["a"])["path"] = "/nonexistent/pdubench-a";
+  (*ini["b"])["server"] = "knxd_unix";
+  (*ini["b"])["path"] = "/nonexistent/pdubench-b";
+
+  Router r (ini, "main");
+  if (!r.setup ())
+    return false;
+  NetServerPtr srv = NetServerPtr(new LocalServer (r, ini["a"]));
+
+  printf ("%u clients, sizeof(ClientConnection) = %u\n", n,
+          (unsigned) sizeof (ClientConnection));
+
+  Array<ClientConnPtr> conns;
+  Array<int> peers;
+  conns.reserve (n);
+  peers.reserve (n);
+
+  long bytes = live;
+  unsigned long a = allocs;
+  for (unsigned int i = 0; i < n; i++)
+    {
+      int fd[2];
+      if (socketpair (AF_UNIX, SOCK_STREAM, 0, fd) < 0)
+        {
+          perror ("socketpair");
+          return false;
+        }
+      ClientConnPtr c = ClientConnPtr(new ClientConnection (srv, fd[0]));
+      c->start ();
+      if (!c->running)
+        {
+          fprintf (stderr, "client %u did not start\n", i);
+          return false;
+        }
+      conns.push_back (c);
+      peers.push_back (fd[1]);
+    }
+  report_clients ("ClientConnection, idle", n, live - bytes, allocs - a);
+
+  /* EIB_OPEN_GROUPCON, with its length */
+  static const uchar open[] = { 0x00, 0x05, 0x00, 0x26, 0x00, 0x00, 0x00 };
+  bytes = live;
+  a = allocs;
+  for (unsigned int i = 0; i < n; i++)
+    if (write (peers[i], open, sizeof (open)) != sizeof (open))
+      {
+        perror ("write");
+        return false;
+      }
+  for (unsigned int i = 0; i < n; i++)
+    {
+      uchar reply[4];
+      while (recv (peers[i], reply, sizeof (reply), MSG_DONTWAIT) != sizeof (reply))
+        ev_run (EV_DEFAULT_ EVRUN_ONCE);
+      if (EIBTYPE (reply + 2) != EIB_OPEN_GROUPCON)
+        {
+          fprintf (stderr, "client %u: group socket refused\n", i);
+          return false;
+        }
+    }
+  report_clients ("ClientConnection, group", n, live - bytes, allocs - a);
+
+  for (unsigned int i = 0; i < n; i++)
+    {
+      conns[i]->stop ();
+      close (peers[i]);
+    }
+  return true;
+}
+
+/** a TP1 standard frame; appends the checksum */
+static CArray
+frame (std::initializer_list<uint8_t> b)
+{
+  CArray c (b);
+  uint8_t cs = 0;
+  for (unsigned int i = 0; i < c.size(); i++)
+    cs ^= c[i];
+  c.push_back (~cs);
+  return c;
+}
+
+static unsigned int
+gcd (unsigned int a, unsigned int b)
+{
+  while (b)
+    {
+      unsigned int r = a % b;
+      a = b;
+      b = r;
+    }
+  return a;
+}
+
+static bool
+readCapture (const char *file, Array<CArray> &frames)
+{
+  FILE *f = fopen (file, "r");
+  if (!f)
+    {
+      perror (file);
+      return false;
+    }
+  char line[1024];
+  while (fgets (line, sizeof (line), f))
+    {
+      char *p = strchr (line, ':');
+      p = p ? p + 1 : line;
+      if (line[0] == '#')
+        continue;
+      CArray c;
+      char *e;
+      unsigned long v;
+      while ((v = strtoul (p, &e, 16)), e != p && v <= 0xff)
+        {
+          c.push_back (v);
+          p = e;
+        }
+      if (c.size())
+        frames.push_back (c);
+    }
+  fclose (f);
+  return true;
+}
+
+int
+main (int ac, char *ag[])
+{
+  unsigned long iter = 2000000;
+  unsigned int clients = 200;
+  int opt;
+  while ((opt = getopt (ac, ag, "n:c:")) != -1)
+    {
+      if (opt == 'n')
+        iter = strtoul (optarg, NULL, 0);
+      else if (opt == 'c')
+        clients = strtoul (optarg, NULL, 0);
+      else
+        {
+          fprintf (stderr, "usage: %s [-n iterations] [-c clients] [capture]\n", ag[0]);
+          return 1;
+        }
+    }
+
+  IniData ini;
+  TracePtr t = TracePtr(new Trace (ini["main"], "bench"));
+
+  Array<CArray> frames;
+  if (optind < ac)
+    {
+      if (!readCapture (ag[optind], frames))
+        return 1;
+    }
+  else
+    {
+      /* weight, frame */
+      static const struct { unsigned weight; CArray f; } mix[] = {
+        /* group write, 6 bit */
+        { 40, frame ({ 0xbc, 0x11, 0x0a, 0x0a, 0x03, 0xe1, 0x00, 0x81 }) },
+        /* group write, DPT 9 */
+        { 25, frame ({ 0xbc, 0x11, 0x0b, 0x0a, 0x04, 0xe3, 0x00, 0x80, 0x0c, 0x1a }) },
+        /* group response, DPT 9 */
+        { 15, frame ({ 0xbc, 0x11, 0x0b, 0x0a, 0x04, 0xe3, 0x00, 0x40, 0x0c, 0x1a }) },
+        /* group read */
+        { 10, frame ({ 0xbc, 0x11, 0x01, 0x0a, 0x04, 0xe1, 0x00, 0x00 }) },
+        /* T_Connect */
+        { 3, frame ({ 0xb0, 0x11, 0xff, 0x11, 0x14, 0x60, 0x80 }) },
+        /* A_Memory_Read */
+        { 3, frame ({ 0xb0, 0x11, 0xff, 0x11, 0x14, 0x63, 0x42, 0x04, 0x01, 0x04 }) },
+        /* A_PropertyValue_Read */
+        { 2, frame ({ 0xb0, 0x11, 0xff, 0x11, 0x14, 0x65, 0x46, 0xd5, 0x00, 0x0b, 0x10, 0x01 }) },
+        /* T_ACK */
+        { 2, frame ({ 0xb0, 0x11, 0x14, 0x11, 0xff, 0x60, 0xc2 }) },
+      };
+      for (unsigned int i = 0; i < sizeof (mix) / sizeof (mix[0]); i++)
+        for (unsigned int j = 0; j < mix[i].weight; j++)
+          frames.push_back (mix[i].f);
+    }
+
+  Array<Sample> samples;
+  for (unsigned int i = 0; i < frames.size(); i++)
+    {
+      LPDUPtr lp = LPDU::fromPacket (frames[i], t);
+      if (lp->getType () != L_Data)
+        {
+          t->TracePacket (0, "not L_Data, skipped", frames[i]);
+          continue;
+        }
+      Sample s;
+      s.l = dynamic_unique_cast<L_Data_PDU> (std::move (lp));
+      s.raw = frames[i];
+      s.cemi = L_Data_ToCEMI (0x29, s.l);
+      s.emi1 = L_Data_ToEMI (0x49, s.l);
+      s.emi2 = L_Data_ToEMI (0x29, s.l);
+      s.ip.service = ROUTING_INDICATION;
+      s.ip.data = s.cemi;
+      s.ipraw = s.ip.ToPacket ();
+      samples.push_back (std::move (s));
+    }
+  if (samples.empty ())
+    {
+      fprintf (stderr, "no L_Data frames\n");
+      return 1;
+    }
+  /* spread the frames out, so that runs of the same kind don't flatter
+   * the branch predictor */
+  unsigned int n = samples.size(), step = n / 3 + 1;
+  while (gcd (step, n) != 1)
+    step++;
+  Array<const Sample *> order;
+  for (unsigned int i = 0; i < n; i++)
+    order.push_back (&samples[(i * step) % n]);
+
+  struct sockaddr_in src;
+  memset (&src, 0, sizeof (src));
+  src.sin_family = AF_INET;
+
+  printf ("%lu iterations, %u frames\n", iter, (unsigned) samples.size());
+
+  report ("LPDU::fromPacket", bench (order, iter,
+          [&t](const Sample &s) { LPDU::fromPacket (s.raw, t); }));
+  report ("L_Data_PDU::ToPacket", bench (order, iter,
+          [](const Sample &s) { s.l->ToPacket (); }));
+  report ("TPDU::fromPacket", bench (order, iter,
+          [&t](const Sample &s) { TPDU::fromPacket (s.l->data, t); }));
+  report ("APDU::fromPacket", bench (order, iter,
+          [&t](const Sample &s) { APDU::fromPacket (s.l->data, t); }));
+  report ("CEMI_to_L_Data", bench (order, iter,
+          [&t](const Sample &s) { CEMI_to_L_Data (s.cemi, t); }));
+  report ("L_Data_ToCEMI", bench (order, iter,
+          [](const Sample &s) { L_Data_ToCEMI (0x29, s.l); }));
+  report ("EMI_to_L_Data (EMI1)", bench (order, iter,
+          [&t](const Sample &s) { EMI_to_L_Data (s.emi1, t); }));
+  report ("EMI_to_L_Data (EMI2)", bench (order, iter,
+          [&t](const Sample &s) { EMI_to_L_Data (s.emi2, t); }));
+  report ("L_Data_ToEMI", bench (order, iter,
+          [](const Sample &s) { L_Data_ToEMI (0x29, s.l); }));
+  report ("EIBNetIPPacket::fromPacket", bench (order, iter,
+          [&src](const Sample &s) { delete EIBNetIPPacket::fromPacket (s.ipraw, src); }));
+  report ("EIBNetIPPacket::ToPacket", bench (order, iter,
+          [](const Sample &s) { s.ip.ToPacket (); }));
+  report ("L_Data_PDU::Decode", bench (order, iter / 10,
+          [&t](const Sample &s) { s.l->Decode (t); }));
+  report ("L_Data_PDU::text", bench (order, iter,
+          [&t](const Sample &s) { s.l->text (t); }));
+
+  if (clients && !bench_clients (clients))
+    return 1;
+  return 0;
+}
@@ -85,6 +85,7 @@ main (int ac, char *ag[])
   struct sockaddr_in caddr;
   EIBNetIPSocket *sock;
   ev_timer timeout;
+  loop = EV_DEFAULT;
   ev_timer_init(&timeout, &end_me, 10.,0.);
   ev_timer_start(EV_DEFAULT_ &timeout);
 
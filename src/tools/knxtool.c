@@ -46,6 +46,89 @@ open_con (const char *uri)
   return con;
 }
 
+/* print a block of entries returned by EIB_Cache_Dump / EIB_Cache_ReadMulti */
+static void
+printCacheEntries (int len, uchar * buf)
+{
+  int i = 0;
+  while (i + 5 <= len)
+    {
+      eibaddr_t src = (buf[i] << 8) | buf[i + 1];
+      eibaddr_t dst = (buf[i + 2] << 8) | buf[i + 3];
+      int dlen = buf[i + 4];
+      uchar *data = buf + i + 5;
+
+      i += 5 + dlen;
+      if (i > len)
+	break;
+      printGroup (dst);
+      if (dlen < 2)
+	{
+	  printf (": no data\n");
+	  continue;
+	}
+      switch (data[1] & 0xC0)
+	{
+	case 0x40:
+	  printf (": Response");
+	  break;
+	case 0x80:
+	  printf (": Write");
+	  break;
+	}
+      printf (" from ");
+      printIndividual (src);
+      printf (": ");
+      if (dlen == 2)
+	printf ("%02X", data[1] & 0x3F);
+      else
+	printHex (dlen - 2, data + 2);
+      printf ("\n");
+    }
+}
+
+/* print a group telegram as received by EIBGetGroup_Src */
+static void
+printGroupPacket (int len, uchar * buf, eibaddr_t src, eibaddr_t dest)
+{
+  if (buf[0] & 0x3 || (buf[1] & 0xC0) == 0xC0)
+    {
+      printf ("Unknown APDU from ");
+      printIndividual (src);
+      printf (" to ");
+      printGroup (dest);
+      printf (": ");
+      printHex (len, buf);
+      printf ("\n");
+      return;
+    }
+  switch (buf[1] & 0xC0)
+    {
+    case 0x00:
+      printf ("Read");
+      break;
+    case 0x40:
+      printf ("Response");
+      break;
+    case 0x80:
+      printf ("Write");
+      break;
+    }
+  printf (" from ");
+  printIndividual (src);
+  printf (" to ");
+  printGroup (dest);
+  if (buf[1] & 0xC0)
+    {
+      printf (": ");
+      if (len == 2)
+	printf ("%02X", buf[1] & 0x3F);
+      else
+	printHex (len - 2, buf + 2);
+    }
+  printf ("\n");
+}
+
 int
 main (int ac, char *ag[])
 {
@@ -82,7 +165,7 @@ msetkey grouplisten groupresponse groupsresponse groupsocketlisten groupsocketre
 vbusmonitor1poll groupreadresponse groupcacheenable groupcachedisable groupcacheclear groupcacheremove \n\
 groupcachereadsync groupcacheread mwriteplain mrestart groupsocketwrite groupsocketswrite \n\
 xpropread xpropwrite groupcachelastupdates busmonitor3 vbusmonitor3 eibread-cgi eibwrite-cgi \n\
-vbusmonitor1time\n");
+vbusmonitor1time groupcachedump groupcachereadmulti groupcachehistory groupcachesubscribe\n");
 	  return 0;
     }
 
@@ -528,6 +611,102 @@ vbusmonitor1time\n");
 	}
       printf ("\n");
     }
+  else if (strcmp (prog, "groupcachedump") == 0)
+    {
+      uchar ebuf[4096];
+      eibaddr_t start = 0, end = 0xFFFF;
+
+      if (ac != 2 && ac != 4)
+	die ("usage: %s url [start-groupaddr end-groupaddr]", prog);
+      con = open_con(ag[1]);
+      if (ac == 4)
+	{
+	  start = readgaddr (ag[2]);
+	  end = readgaddr (ag[3]);
+	}
+
+      len = EIB_Cache_Dump (con, start, end, sizeof (ebuf), ebuf);
+      while (len > 0)
+	{
+	  printCacheEntries (len, ebuf);
+	  len = EIB_Cache_GetEntries (con, sizeof (ebuf), ebuf);
+	}
+      if (len == -1)
+	die ("Read failed");
+    }
+  else if (strcmp (prog, "groupcachereadmulti") == 0)
+    {
+      uchar ebuf[4096];
+      int i, timeout;
+
+      if (ac < 4 || ac - 3 > (int) sizeof (buf) / 2)
+	die ("usage: %s url timeout groupaddr...", prog);
+      con = open_con(ag[1]);
+      timeout = atoi (ag[2]);
+      for (i = 3; i < ac; i++)
+	{
+	  dest = readgaddr (ag[i]);
+	  buf[(i - 3) * 2] = (dest >> 8) & 0xff;
+	  buf[(i - 3) * 2 + 1] = dest & 0xff;
+	}
+
+      len = EIB_Cache_ReadMulti (con, (ac - 3) * 2, buf, timeout, 0,
+				 sizeof (ebuf), ebuf);
+      while (len > 0)
+	{
+	  printCacheEntries (len, ebuf);
+	  len = EIB_Cache_GetEntries (con, sizeof (ebuf), ebuf);
+	}
+      if (len == -1)
+	die ("Read failed");
+    }
+  else if (strcmp (prog, "groupcachehistory") == 0)
+    {
+      uchar ebuf[65536];
+      uint32_t start = 0;
+      int i = 0;
+
+      if (ac != 3 && ac != 4)
+	die ("usage: %s url groupaddr [start-position]", prog);
+      con = open_con(ag[1]);
+      dest = readgaddr (ag[2]);
+      if (ac == 4)
+	start = atoi (ag[3]);
+
+      len = EIB_Cache_History (con, dest, start, 0, sizeof (ebuf), ebuf);
+      if (len == -1)
+	die ("Read failed");
+
+      while (i + 11 <= len)
+	{
+	  uint32_t seq = (ebuf[i] << 24) | (ebuf[i + 1] << 16) | (ebuf[i + 2] << 8) | ebuf[i + 3];
+	  eibaddr_t hsrc = (ebuf[i + 8] << 8) | ebuf[i + 9];
+	  int dlen = ebuf[i + 10];
+	  uchar *data = ebuf + i + 11;
+
+	  i += 11 + dlen;
+	  if (i > len || dlen < 2)
+	    break;
+	  printf ("%u: ", seq);
+	  switch (data[1] & 0xC0)
+	    {
+	    case 0x40:
+	      printf ("Response");
+	      break;
+	    case 0x80:
+	      printf ("Write");
+	      break;
+	    }
+	  printf (" from ");
+	  printIndividual (hsrc);
+	  printf (": ");
+	  if (dlen == 2)
+	    printf ("%02X", data[1] & 0x3F);
+	  else
+	    printHex (dlen - 2, data + 2);
+	  printf ("\n");
+	}
+    }
   else if (strcmp (prog, "groupcacheread") == 0)
     {
       if (ac != 3)
@@ -804,44 +983,54 @@ vbusmonitor1time\n");
 	    die ("Read failed");
 	  if (len < 2)
 	    die ("Invalid Packet");
-	  if (buf[0] & 0x3 || (buf[1] & 0xC0) == 0xC0)
-	    {
-	      printf ("Unknown APDU from ");
-	      printIndividual (src);
-	      printf (" to ");
-	      printGroup (dest);
-	      printf (": ");
-	      printHex (len, buf);
-	      printf ("\n");
-	    }
-	  else
-	    {
-	      switch (buf[1] & 0xC0)
-		{
-		case 0x00:
-		  printf ("Read");
-		  break;
-		case 0x40:
-		  printf ("Response");
-		  break;
-		case 0x80:
-		  printf ("Write");
-		  break;
-		}
-	      printf (" from ");
-	      printIndividual (src);
-	      printf (" to ");
-	      printGroup (dest);
-	      if (buf[1] & 0xC0)
-		{
-		  printf (": ");
-		  if (len == 2)
-		    printf ("%02X", buf[1] & 0x3F);
-		  else
-		    printHex (len - 2, buf + 2);
-		}
-	      printf ("\n");
-	    }
+	  printGroupPacket (len, buf, src, dest);
+	}
+    }
+  else if (strcmp (prog, "groupcachesubscribe") == 0)
+    {
+      int i, changes_only = 0;
+
+      if (ac > 1 && strcmp (ag[1], "-c") == 0)
+	{
+	  changes_only = 1;
+	  ac--;
+	  ag++;
+	}
+      if (ac < 2 || ac - 2 > (int) sizeof (buf) / 4)
+	die ("usage: %s [-c] url [groupaddr[-groupaddr]...]", prog);
+      con = open_con(ag[1]);
+      if (ac == 2)
+	{
+	  buf[0] = buf[1] = 0x00;
+	  buf[2] = buf[3] = 0xFF;
+	}
+      for (i = 2; i < ac; i++)
+	{
+	  char *dash = strchr (ag[i], '-');
+	  eibaddr_t lo, hi;
+
+	  if (dash)
+	    *dash = 0;
+	  lo = readgaddr (ag[i]);
+	  hi = dash ? readgaddr (dash + 1) : lo;
+	  buf[(i - 2) * 4] = (lo >> 8) & 0xff;
+	  buf[(i - 2) * 4 + 1] = lo & 0xff;
+	  buf[(i - 2) * 4 + 2] = (hi >> 8) & 0xff;
+	  buf[(i - 2) * 4 + 3] = hi & 0xff;
+	}
+
+      if (EIB_Cache_Subscribe (con, ac == 2 ? 4 : (ac - 2) * 4, buf,
+			       changes_only) == -1)
+	die ("Subscribe failed");
+
+      while (1)
+	{
+	  len = EIBGetGroup_Src (con, sizeof (buf), buf, &src, &dest);
+	  if (len == -1)
+	    die ("Read failed");
+	  if (len < 2)
+	    die ("Invalid Packet");
+	  printGroupPacket (len, buf, src, dest);
 	}
     }
   else if (strcmp (prog, "groupsocketread") == 0)
@@ -19,23 +19,15 @@
 
 #include <stdlib.h>
 #include <errno.h>
-#include <sys/poll.h>
 #include "usb.h"
 #include "types.h"
 
 #define	LIBUSB_LOG_LEVEL_ERROR 0
 #define	LIBUSB_LOG_LEVEL_DEBUG 1
-static void pollfd_added_cb (int fd UNUSED, short events UNUSED, void *user_data)
-{
-  USBLoop *loop = static_cast<USBLoop *>(user_data);
-  loop->setup();
-}
 
-static void pollfd_removed_cb (int fd UNUSED, void *user_data)
-{
-  USBLoop *loop = static_cast<USBLoop *>(user_data);
-  loop->setup();
-}
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000105)
+#define HAVE_LIBUSB_INTERRUPT 1
+#endif
 
 USBLoop::USBLoop (TracePtr tr)
 {
@@ -52,78 +44,30 @@ USBLoop::USBLoop (TracePtr tr)
   else
     libusb_set_debug(context,LIBUSB_LOG_LEVEL_ERROR);
 
-  tm.set<USBLoop, &USBLoop::timer_cb>(this);
-  libusb_set_pollfd_notifiers (context, pollfd_added_cb,pollfd_removed_cb, this);
-  setup();
+  thread = std::thread (&USBLoop::run, this);
   TRACEPRINTF (t, 10, "USBLoop-Create");
 }
 
-void USBLoop::timer()
-{
-  struct timeval tv;
-  if (libusb_get_next_timeout (context, &tv) > 0)
-    tm.start(tv.tv_sec+tv.tv_usec/1000000., 0);
-}
-
-void USBLoop::setup()
+void
+USBLoop::run ()
 {
-  ITER(i,fds)
+  while (!stopping)
     {
-      (*i)->stop();
-      delete *i;
+      /* Without libusb_interrupt_event_handler(), this timeout is how
+       * long stopping may take. */
+      struct timeval tv = {1,0};
+      libusb_handle_events_timeout_completed (context, &tv, nullptr);
     }
-  fds.clear();
-  const struct libusb_pollfd **usb_fds = libusb_get_pollfds(context);
-  const struct libusb_pollfd **orig_usb_fds = usb_fds;
-  for(const struct libusb_pollfd *it = *usb_fds; it != NULL; it = *++usb_fds)
-    {
-      if (it->events & POLLIN)
-        {
-          ev::io *io = new ev::io();
-          io->set<USBLoop, &USBLoop::io_cb>(this);
-          io->start(it->fd,ev::READ);
-          fds.push_back(io);
-          TRACEPRINTF (t, 10, "USBLoop read %d",it->fd);
-        }
-      if (it->events & POLLOUT)
-        {
-          ev::io *io = new ev::io();
-          io->set<USBLoop, &USBLoop::io_cb>(this);
-          io->start(it->fd,ev::WRITE);
-          fds.push_back(io);
-          TRACEPRINTF (t, 10, "USBLoop write %d",it->fd);
-        }
-    }
-  free(orig_usb_fds);
 }
 
 USBLoop::~USBLoop ()
 {
-  if (context)
-    libusb_exit (context);
-  tm.stop();
-  ITER(i,fds)
-    {
-      (*i)->stop();
-      delete *i;
-    }
-  fds.clear();
-}
-
-void
-USBLoop::timer_cb (ev::timer &w UNUSED, int revents UNUSED)
-{
-  struct timeval tv1 = {0,0};
-  libusb_handle_events_timeout (context, &tv1);
-  timer();
+  if (!context)
+    return;
+  stopping = true;
+#ifdef HAVE_LIBUSB_INTERRUPT
+  libusb_interrupt_event_handler (context);
+#endif
+  thread.join();
+  libusb_exit (context);
 }
-
-void
-USBLoop::io_cb (ev::io &w UNUSED, int revents UNUSED)
-{
-  // TRACEPRINTF (t, 10, "USBLoop hit %d", w.fd);
-  struct timeval tv1 = {0,0};
-  libusb_handle_events_timeout (context, &tv1);
-  timer();
-}
-
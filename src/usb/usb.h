@@ -20,29 +20,31 @@
 #ifndef USB_H
 #define USB_H
 
-#include <ev++.h>
+#include <atomic>
+#include <thread>
 #include <libusb.h>
 
 #include "trace.h"
 
+/** libusb context, with its event handling in a separate thread.
+ *
+ * Transfer callbacks are called in that thread. They must hand the
+ * transfer over to the main loop (see USBLowLevelDriver) instead of
+ * doing any real work.
+ */
 class USBLoop
 {
   TracePtr t;
 
-  Array < ev::io * > fds;
-  ev::timer tm;
-  void timer();
-
-  void timer_cb (ev::timer &w, int revents);
-  void io_cb (ev::io &w, int revents);
+  std::thread thread;
+  std::atomic<bool> stopping {false};
+  void run ();
 
 public:
   libusb_context *context;
 
   USBLoop (TracePtr tr);
   virtual ~USBLoop ();
-
-  void setup();
 };
 
 #endif
@@ -46,6 +46,29 @@ if knxd -e 1.2.3 --stop-right-now -T -b dummy: -b dummy: >$EF 2>&1; then
 	exit 1
 fi
 
+# binary trace: a ring which wrapped, leaving a pad record at its end
+# that is shorter than a record header
+TF=$(tempfile)
+bt() { printf "$2" | dd of=$TF bs=1 seek=$1 conv=notrunc 2>/dev/null; }
+head -c 192 /dev/zero >$TF
+bt 0 'KNXDTRC1\001\000\000\000\100' # version, hdr_size; strtab_size=0
+bt 24 '\200' # ring_size
+bt 32 '\250' # head
+bt 40 '\100' # tail
+bt 128 '\060\000\001\000\377\377\377\377'
+bt 144 '\001'
+bt 152 's\001\000ts\005\000first'
+bt 176 '\020' # pad
+bt 64 '\050\000\001\000\377\377\377\377'
+bt 80 '\002'
+bt 88 's\001\000ts\006\000second'
+if ! knxd-tracefmt $TF >$EF 2>&1 || ! grep -q '] first$' $EF || ! grep -q '] second$' $EF ; then
+	echo "Bad trace file reading" >&2
+	cat $EF 2>&1
+	exit 1
+fi
+rm -f $TF
+
 if ! knxd -e 1.2.3 --stop-right-now -c -b dummy: -b dummy: >$EF 2>&1; then
   echo "Group cache disabled – tests skipped – proceed on your own!"
   rm -f $EF
@@ -60,16 +83,18 @@ L2=$(tempfile)
 L3=$(tempfile)
 L4=$(tempfile)
 L5=$(tempfile)
+L6=$(tempfile)
 E1=$(tempfile)
 E2=$(tempfile)
 E3=$(tempfile)
 E4=$(tempfile)
 E5=$(tempfile)
+E6=$(tempfile)
 
 PORT=$((9999 + $$))
 PORT2=$((9998 + $$))
 
-knxd -n K1 -B log -t 0xfffc -f 9 -e 4.1.0 -E 4.1.1:5 -B log -c -B log -u$S1 --multi-port -D -B log -A delay=200 -B pace -R -B log -T --Server=224.99.98.97:$PORT -bdummy: &
+knxd -n K1 -B log -t 0xfffc -f 9 -e 4.1.0 -E 4.1.1:5 -B log -A history=4 -A eviction=clock -c -B log -u$S1 --multi-port -D -B log -A delay=200 -B pace -R -B log -T --Server=224.99.98.97:$PORT -bdummy: &
 KNX1=$!
 trap 'echo T1; rm -f $L1 $L2 $E1 $E2 $EF; kill $KNX1; wait' 0 1 2
 
@@ -112,6 +137,9 @@ if ! knxtool groupswrite local:$S1 1/2/3 7 ; then echo X4; exit 1; fi
 sleep 1
 echo xmit 3
 if ! knxtool groupswrite local:$S3 1/2/3 8 ; then echo X5; exit 1; fi
+# only now, so that it does not take one of the addresses above
+knxtool groupcachesubscribe -c local:$S1 1/2/0-1/2/7 >$L6 2>$E6 &
+PL6=$!
 sleep 1
 echo xmit 2
 if ! knxtool groupwrite local:$S2 1/2/3 4 5 6 ; then echo X6; exit 1; fi
@@ -120,12 +148,15 @@ kill $PL4 || true
 if ! knxtool groupcacheread local:$S1 1/2/3 >>$L4 2>>$E4 ; then echo X7; exit 1;
 fi
 if ! knxtool groupcachelastupdates local:$S1 3 1 >>$L4 2>>$E4 ; then echo X7; exit 1; fi
+if ! knxtool groupcachedump local:$S1 >>$L4 2>>$E4 ; then echo X8; exit 1; fi
+if ! knxtool groupcachereadmulti local:$S1 0 1/2/3 1/2/4 >>$L4 2>>$E4 ; then echo X9; exit 1; fi
+if ! knxtool groupcachehistory local:$S1 1/2/3 >>$L4 2>>$E4 ; then echo X10; exit 1; fi
 
 #read RETURN
 kill $KNX1 $KNX2 $KNX3
 sleep 1
-kill $PL1 $PL2 $PL3 $PL5 || true
-trap 'echo T3; rm -f $L1 $L2 $L3 $L4 $L5 $E1 $E2 $E3 $E4 $E5 $EF' 0 1 2
+kill $PL1 $PL2 $PL3 $PL5 $PL6 || true
+trap 'echo T3; rm -f $L1 $L2 $L3 $L4 $L5 $L6 $E1 $E2 $E3 $E4 $E5 $E6 $EF' 0 1 2
 sleep 1
 #ls -l $L1 $L2 $E1 $E2
 #cat $L1 $L2 $E1 $E2
@@ -134,6 +165,7 @@ sed -e 's/^/E vbusmonitor 2: /' <$E2
 sed -e 's/^/E vbusmonitor 3: /' <$E3
 sed -e 's/^/E groupcacheread: /' <$E4
 sed -e 's/^/E grouplisten: /' <$E5
+sed -e 's/^/E groupcachesubscribe: /' <$E6
 
 E=""
 diff -u "$(dirname "$0")"/logs/monitor1 $L1 || E=1$E
@@ -141,10 +173,153 @@ diff -u "$(dirname "$0")"/logs/monitor2 $L2 || E=2$E
 diff -u "$(dirname "$0")"/logs/monitor3 $L3 || E=3$E
 diff -u "$(dirname "$0")"/logs/cache $L4 || E=4$E
 diff -u "$(dirname "$0")"/logs/listen $L5 || E=5$E
+diff -u "$(dirname "$0")"/logs/subscribe $L6 || E=6$E
 test -z "$E"
 
+# the default eviction policy drops the oldest entry, even if it was read
+S4=$(tempfile); rm $S4
+knxd -n K4 -e 4.4.0 -E 4.4.1:5 -A max-size=2 -c -u$S4 -b dummy: &
+KNX4=$!
+trap 'echo T4; rm -f $L1 $L2 $L3 $L4 $L5 $L6 $E1 $E2 $E3 $E4 $E5 $E6 $EF; kill $KNX4; wait' 0 1 2
+sleep 1
+knxtool groupswrite local:$S4 1/2/1 1
+knxtool groupswrite local:$S4 1/2/2 2
+knxtool groupcacheread local:$S4 1/2/1 >$EF
+knxtool groupswrite local:$S4 1/2/3 3
+sleep 1
+knxtool groupcachedump local:$S4 >$L4
+kill $KNX4
+trap 'echo T3; rm -f $L1 $L2 $L3 $L4 $L5 $L6 $E1 $E2 $E3 $E4 $E5 $E6 $EF' 0 1 2
+wait $KNX4 || true
+if grep -q "^1/2/1:" $L4 || ! grep -q "^1/2/2:" $L4 || ! grep -q "^1/2/3:" $L4 ; then
+	echo "Bad cache eviction" >&2
+	cat $L4 2>&1
+	exit 1
+fi
+
+# routing domains: frames cross the bridge in both directions
+S5=$(tempfile); rm $S5
+S6=$(tempfile); rm $S6
+C5=$(tempfile)
+cat >$C5 <<END
+[main]
+addr=4.5.0
+client-addrs=4.5.1:5
+connections=server
+domains=line2
+[server]
+server=knxd_unix
+path=$S5
+[line2]
+addr=4.6.0
+client-addrs=4.6.1:5
+connections=server2
+[server2]
+server=knxd_unix
+path=$S6
+END
+knxd $C5 &
+KNX5=$!
+trap 'echo T5; rm -f $L1 $L2 $L3 $L4 $L5 $L6 $E1 $E2 $E3 $E4 $E5 $E6 $EF $C5; kill $KNX5; wait' 0 1 2
+sleep 1
+knxtool grouplisten local:$S6 1/2/4 >$L5 2>$E5 &
+PL5=$!
+knxtool grouplisten local:$S5 1/2/5 >$L6 2>$E6 &
+PL6=$!
+sleep 1
+knxtool groupswrite local:$S5 1/2/4 4
+knxtool groupswrite local:$S6 1/2/5 5
+sleep 1
+kill $PL5 $PL6 || true
+kill $KNX5
+trap 'echo T3; rm -f $L1 $L2 $L3 $L4 $L5 $L6 $E1 $E2 $E3 $E4 $E5 $E6 $EF $C5' 0 1 2
+wait $KNX5
+if ! grep -q "^Write from 4\.5\.[0-9]*: 04$" $L5 || ! grep -q "^Write from 4\.6\.[0-9]*: 05$" $L6 ; then
+	echo "Bad domain bridging" >&2
+	cat $L5 $L6 $E5 $E6 2>&1
+	exit 1
+fi
+
+# binary trace written by knxd itself
+S7=$(tempfile); rm $S7
+TF=$(tempfile); rm $TF
+cat >$C5 <<END
+[main]
+addr=4.7.0
+client-addrs=4.7.1:5
+connections=server,bus
+debug=dbg
+[server]
+server=knxd_unix
+path=$S7
+debug=dbg
+[bus]
+driver=dummy
+[dbg]
+trace-file=$TF
+trace-mask=0xffff
+END
+knxd $C5 &
+KNX7=$!
+trap 'echo T7; rm -f $L1 $L2 $L3 $L4 $L5 $L6 $E1 $E2 $E3 $E4 $E5 $E6 $EF $C5 $TF; kill $KNX7; wait' 0 1 2
+sleep 1
+knxtool groupswrite local:$S7 1/2/7 7
+sleep 1
+kill $KNX7
+trap 'echo T3; rm -f $L1 $L2 $L3 $L4 $L5 $L6 $E1 $E2 $E3 $E4 $E5 $E6 $EF $C5 $TF' 0 1 2
+wait $KNX7
+if ! knxd-tracefmt $TF >$EF 2>&1 || ! grep -q "\] OpenGroup 1/2/7 WO$" $EF || ! grep -q "\] ReadMessage(004): 00 25 00 87$" $EF ; then
+	echo "Bad trace file round trip" >&2
+	cat $EF 2>&1
+	exit 1
+fi
+
+# pcap capture: a section header, the link's interface, one packet
+S8=$(tempfile); rm $S8
+P8=$(tempfile); rm $P8
+cat >$C5 <<END
+[main]
+addr=4.8.0
+client-addrs=4.8.1:5
+connections=server,bus
+[server]
+server=knxd_unix
+path=$S8
+[bus]
+driver=dummy
+filters=cap
+[cap]
+filter=pcap
+file=$P8
+END
+knxd $C5 &
+KNX8=$!
+trap 'echo T8; rm -f $L1 $L2 $L3 $L4 $L5 $L6 $E1 $E2 $E3 $E4 $E5 $E6 $EF $C5 $TF $P8; kill $KNX8; wait' 0 1 2
+sleep 1
+knxtool groupswrite local:$S8 1/2/8 8
+sleep 1
+kill $KNX8
+trap 'echo T3; rm -f $L1 $L2 $L3 $L4 $L5 $L6 $E1 $E2 $E3 $E4 $E5 $E6 $EF $C5 $TF $P8' 0 1 2
+wait $KNX8
+u32() { od -An -tu4 -j$1 -N4 $P8 | tr -d ' '; }
+u16() { od -An -tu2 -j$1 -N2 $P8 | tr -d ' '; }
+OFF=0; BLOCKS=""; SIZE=$(stat -c %s $P8)
+while [ $OFF -lt $SIZE ]; do
+	BLOCKS="$BLOCKS $(u32 $OFF)"
+	[ "$(u32 $OFF)" != 6 ] || EPB=$OFF
+	OFF=$((OFF + $(u32 $((OFF + 4)))))
+done
+# SHB: 0x0A0D0D0A, byte order magic 0x1A2B3C4D; IDB: link type 252
+if [ "$BLOCKS" != " 168627466 1 6" ] || [ $OFF != $SIZE ] || \
+	[ "$(u32 8)" != 439041101 ] || [ "$(u16 $(($(u32 4) + 8)))" != 252 ] || \
+	[ "$(od -An -c -j$(($EPB + 32)) -N4 $P8 | tr -d ' ')" != cemi ] ; then
+	echo "Bad pcap file" >&2
+	od -Ax -tx1 $P8 >&2
+	exit 1
+fi
+
 set +ex
 
-rm -f $L1 $L2 $L3 $L4 $L5 $E1 $E2 $E3 $E4 $E5 $EF
+rm -f $P8 $TF $C5 $L1 $L2 $L3 $L4 $L5 $L6 $E1 $E2 $E3 $E4 $E5 $E6 $EF
 trap '' 0 1 2 
 echo DONE OK